@@ -59,31 +59,47 @@
  */
 #define ADC_CONFIG_REG 0
 
+/// Channel data, each read steps to the next channel (ends burst reads)
 #define ADC_DATA_REG 1
 
+/// Result table window: ADC_LEN x u16, big endian (same order as ADC_DATA_REG)
+#define ADC_TABLE_REG 2
+
 // i2cadapter data
 static uint8_t read_channel;
 
 static GATE_RESULT adc_i2cadapter_read(uint8_t reg, uint8_t* data, uint8_t* data_len);
 static GATE_RESULT adc_i2cadapter_write(uint8_t reg, uint8_t* data, uint8_t data_len);
+static GATE_RESULT adc_i2cadapter_window(uint8_t reg, const uint8_t** data, uint16_t* data_len);
+static void adc_i2cadapter_release(uint8_t reg);
 
 static GATE_I2CADAPTER adc_i2cadapter = {
 	.uid = 0x0040,
 	.major_version = 1,
-	.minor_version = 0,
+	.minor_version = 1,
 	.read = adc_i2cadapter_read,
 	.write = adc_i2cadapter_write,
-	.num_registers = 2,
+	.window = adc_i2cadapter_window,
+	.release = adc_i2cadapter_release,
+	.num_registers = 3,
+	.read_effects = 1 << ADC_DATA_REG, // channel cursor
 };
 
 #ifdef HAL_ADC_NISR
+/// ADC polling period (conversion takes ~60 us)
+#define ADC_TASK_PERIOD SYSTICK_MS(1)
+
 static GATE_TASK adc_task = {
 	.task = adc_loop,
+	.period = ADC_TASK_PERIOD,
 };
 #endif
 
 static GATE_RESULT adc_i2cadapter_read(uint8_t reg, uint8_t* data, uint8_t* data_len)
 {
+	uint16_t frame[ADC_LEN];
+	uint16_t v;
+
 	debug("# adc->read(%i, buf, %i)\n", reg, *data_len);
 
 	if (reg != ADC_DATA_REG) {
@@ -94,25 +110,52 @@ static GATE_RESULT adc_i2cadapter_read(uint8_t reg, uint8_t* data, uint8_t* data
 		return GR_OK;
 	}
 
+	if (adc_is_10bit() && *data_len < 2) {
+		return GR_INVALID_ARG;
+	}
+
+	// a copy, the front frame may be switched under a direct read
+	adc_get_frame(frame);
+	v = frame[read_channel];
+
 	if (adc_is_10bit()) {
 		// 10-bit
-		data[0] = adc_result[read_channel] >> 8;
-		data[1] = adc_result[read_channel] & 0xFF;
+		data[0] = v >> 8;
+		data[1] = v & 0xFF;
 		*data_len = 2;
 	} else {
 		// 8-bit
-		*data = adc_result[read_channel] & 0xFF;
+		*data = v & 0xFF;
 		*data_len = 1;
 	}
 
 	// circle read
-	if (read_channel++ >= 8) {
+	if (++read_channel >= ADC_LEN) {
 		read_channel = 0;
 	}
 
 	return GR_OK;
 }
 
+static GATE_RESULT adc_i2cadapter_window(uint8_t reg, const uint8_t** data, uint16_t* data_len)
+{
+	if (reg != ADC_TABLE_REG) {
+		return GR_NO_ACCESS;
+	}
+
+	// don't publish new sweeps until the transfer ends
+	adc_hold = true;
+	*data = adc_table;
+	*data_len = sizeof(adc_table);
+	return GR_OK;
+}
+
+static void adc_i2cadapter_release(uint8_t reg)
+{
+	(void)reg;
+	adc_hold = false;
+}
+
 static GATE_RESULT adc_i2cadapter_write(uint8_t reg, uint8_t* data, uint8_t data_len)
 {
 	debug("# adc->write(%i, buf, %i)\n", reg, data_len);
@@ -145,8 +188,13 @@ static GATE_RESULT adc_i2cadapter_write(uint8_t reg, uint8_t* data, uint8_t data
 			GATE_ADC_DDR &= ~data[1];
 		}
 
-	} else {
+	} else if (reg == ADC_DATA_REG) {
+		if (*data >= ADC_LEN) {
+			return GR_INVALID_ARG;
+		}
 		read_channel = *data;
+	} else {
+		return GR_NO_ACCESS;
 	}
 
 	return GR_OK;
@@ -0,0 +1,112 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** I2C bus statistics adapter
+ * @file i2cstats_i2c.c
+ */
+
+#include "core/i2cadapter.h"
+#include "hal/i2c.h"
+
+#include "i2cstats_i2c.h"
+
+static GATE_RESULT
+i2cstats_i2cadapter_read(uint8_t reg, uint8_t* data, uint8_t* data_len);
+static GATE_RESULT
+i2cstats_i2cadapter_write(uint8_t reg, uint8_t* data, uint8_t data_len);
+
+static GATE_I2CADAPTER i2cstats_i2cadapter = {
+	.uid = I2CSTATS_UID,
+	.major_version = I2CSTATS_MAJOR,
+	.minor_version = I2CSTATS_MINOR,
+	.read = i2cstats_i2cadapter_read,
+	.write = i2cstats_i2cadapter_write,
+	.num_registers = 3,
+};
+
+static GATE_RESULT
+i2cstats_i2cadapter_read(uint8_t reg, uint8_t* data, uint8_t* data_len)
+{
+	i2c_stats_t st;
+	uint8_t* p = data;
+	static const uint8_t sizes[] = { 16, 10, 6 };
+
+	if (!*data_len) {
+		return GR_OK;
+	}
+
+	if (reg < sizeof(sizes) && *data_len < sizes[reg]) {
+		return GR_INVALID_ARG;
+	}
+
+	i2c_stats_read(&st);
+	switch (reg) {
+		case I2CSTATS_CTRL_REG:
+			p = gate_put32(p, st.m_xfers);
+			p = gate_put32(p, st.m_bytes);
+			p = gate_put32(p, st.s_xfers);
+			p = gate_put32(p, st.s_bytes);
+			break;
+
+		case I2CSTATS_ERR_REG:
+			p = gate_put16(p, st.addr_nack);
+			p = gate_put16(p, st.data_nack);
+			p = gate_put16(p, st.arb_lost);
+			p = gate_put16(p, st.bus_errors);
+			p = gate_put16(p, st.timeouts);
+			break;
+
+		case I2CSTATS_TIME_REG:
+			p = gate_put32(p, st.stretch_cycles);
+			p = gate_put16(p, st.isr_max);
+			break;
+
+		default:
+			return GR_NO_ACCESS;
+	}
+
+	*data_len = p - data;
+	return GR_OK;
+}
+
+static GATE_RESULT
+i2cstats_i2cadapter_write(uint8_t reg, uint8_t* data, uint8_t data_len)
+{
+	(void)data;
+
+	if (reg != I2CSTATS_CTRL_REG) {
+		return GR_NO_ACCESS;
+	}
+	if (!data_len) {
+		return GR_INVALID_DATA;
+	}
+
+	i2c_stats_reset();
+	return GR_OK;
+}
+
+// Autoload
+I2C_MODULE_INIT(i2cstats_adapter)
+{
+	gate_i2cadapter_register(&i2cstats_i2cadapter);
+}
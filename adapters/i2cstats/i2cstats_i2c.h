@@ -0,0 +1,68 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** I2C bus statistics adapter
+ * @file i2cstats_i2c.h
+ */
+
+#ifndef I2CSTATS_DRIVER_H
+#define I2CSTATS_DRIVER_H
+
+#include "core/common.h"
+
+/**
+ * @ingroup Drivers
+ * @defgroup I2CStatsAdapter I2C bus statistics adapter
+ *
+ * Available only with HAL_I2C_STATS (I2C_STATS = yes).
+ * All values are big-endian.
+ *
+ * @{
+ */
+
+#define I2CSTATS_UID   0x0011
+#define I2CSTATS_MAJOR 1
+#define I2CSTATS_MINOR 0
+
+/** Control register.
+ * Read: master transfers, master bytes, slave transactions, slave
+ * bytes (4 bytes each).
+ * Write: any data resets all statistics.
+ */
+#define I2CSTATS_CTRL_REG  0x00
+
+/** Errors.
+ * Read: address NACKs, data NACKs, arbitration losses, bus errors,
+ * timeouts (2 bytes each).
+ */
+#define I2CSTATS_ERR_REG   0x01
+
+/** Slave timing.
+ * Read: clock stretch time (4 bytes), longest slave interrupt
+ * (2 bytes), in CPU cycles.
+ */
+#define I2CSTATS_TIME_REG  0x02
+
+/**@}*/
+
+#endif // I2CSTATS_DRIVER_H
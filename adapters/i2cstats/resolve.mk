@@ -0,0 +1,5 @@
+# -*- Makefile -*-
+
+INCLUDE_DIRS += -I${ORFA}/adapters/i2cstats
+
+SRC += ${ORFA}/adapters/i2cstats/i2cstats_i2c.c
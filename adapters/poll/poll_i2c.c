@@ -0,0 +1,342 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** I2C device polling adapter
+ * @file poll_i2c.c
+ */
+
+#include <string.h>
+#include <avr/io.h>
+#include <util/atomic.h>
+
+#include "core/i2cadapter.h"
+#include "core/scheduler.h"
+#include "core/snapshot.h"
+#include "hal/i2c.h"
+
+#include "poll_i2c.h"
+
+#if POLL_SLOTS > 8
+#error "POLL_SLOTS: at most 8 entries"
+#endif
+
+#if POLL_SLOTS * POLL_CACHE_REC > 255
+#error "POLL_SLOTS * POLL_CACHE_REC: cache doesn't fit in a snapshot"
+#endif
+
+/// Poll task period, entry periods are rounded up to it
+#define POLL_TASK_PERIOD SYSTICK_MS(1)
+
+/// Longest entry period in ticks (age check must not wrap)
+#define POLL_PERIOD_MAX  0x3FFF
+
+#define CACHE_LEN (POLL_SLOTS * POLL_CACHE_REC)
+
+static GATE_RESULT
+poll_i2cadapter_read(uint8_t reg, uint8_t* data, uint8_t* data_len);
+static GATE_RESULT
+poll_i2cadapter_write(uint8_t reg, uint8_t* data, uint8_t data_len);
+static GATE_RESULT
+poll_i2cadapter_window(uint8_t reg, const uint8_t** data, uint16_t* data_len);
+static void poll_i2cadapter_release(uint8_t reg);
+
+static GATE_I2CADAPTER poll_i2cadapter = {
+	.uid = POLL_UID,
+	.major_version = POLL_MAJOR,
+	.minor_version = POLL_MINOR,
+	.read = poll_i2cadapter_read,
+	.write = poll_i2cadapter_write,
+	.window = poll_i2cadapter_window,
+	.release = poll_i2cadapter_release,
+	.num_registers = 3,
+	.read_effects = 1 << POLL_LIST_REG,
+};
+
+typedef struct {
+	uint8_t addr;        ///< 8-bit write address
+	uint8_t reg;
+	uint8_t len;         ///< 0 -- free slot
+	uint16_t period_ms;
+	systick_t period;
+	systick_t next_run;
+} poll_entry_t;
+
+// Entries may be set from the TWI interrupt (see wq_apply() in main.c),
+// the task reads them with interrupts off.
+static poll_entry_t list[POLL_SLOTS];
+static volatile uint8_t list_changed; ///< slots set since the last task pass
+static uint8_t list_num;              ///< entry selected for reading
+
+// Cache: the task fills the back frame, the window serves the front one
+static uint8_t cache_frames[2][CACHE_LEN];
+static GATE_SNAPSHOT cache = GATE_SNAPSHOT_INIT(cache_frames);
+static volatile bool cache_hold;      ///< window is open, don't publish
+static bool cache_dirty;
+
+static i2c_xfer_t xfer;
+static uint8_t xfer_slot = POLL_SLOTS; ///< slot being polled, POLL_SLOTS -- none
+static uint8_t xfer_reg;
+static uint8_t xfer_rx[POLL_DATA_LEN];
+
+/** Keep the result of the finished poll in its cache record
+ * A failed poll keeps the last reading.
+ */
+static void poll_store(uint8_t* rec, systick_t now)
+{
+	rec[1] = xfer.status;
+	if (xfer.status == I2C_E_OK) {
+		rec[0] = POLL_F_VALID | POLL_F_FRESH;
+		gate_put16(rec + 2, now);
+		memcpy(rec + 4, xfer_rx, xfer.rx_count);
+	} else {
+		rec[0] |= POLL_F_ERROR;
+	}
+	cache_dirty = true;
+}
+
+/** Publish the back frame, unless the window is open
+ * The new back frame starts as a copy of the published one.
+ */
+static void poll_publish(void)
+{
+	bool published = false;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		if (!cache_hold) {
+			gate_snapshot_publish(&cache);
+			published = true;
+		}
+	}
+	if (published) {
+		memcpy(gate_snapshot_back(&cache), gate_snapshot_front(&cache), CACHE_LEN);
+		cache_dirty = false;
+	}
+}
+
+static void poll_task(void)
+{
+	systick_t now = systick_get();
+	uint8_t* back = gate_snapshot_back(&cache);
+	uint8_t next = POLL_SLOTS;
+	int16_t late = -1;
+
+	if (xfer.status == I2C_E_PENDING) {
+		return;
+	}
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		uint8_t changed = list_changed;
+		list_changed = 0;
+
+		// a poll of the entry that was set since is dropped
+		if (xfer_slot < POLL_SLOTS && !(changed & _BV(xfer_slot))) {
+			poll_store(back + xfer_slot * POLL_CACHE_REC, now);
+		}
+		xfer_slot = POLL_SLOTS;
+
+		for (uint8_t i=0; i < POLL_SLOTS; i++) {
+			poll_entry_t* e = &list[i];
+			uint8_t* rec = back + i * POLL_CACHE_REC;
+
+			if (changed & _BV(i)) {
+				memset(rec, 0, POLL_CACHE_REC);
+				cache_dirty = true;
+			}
+
+			if ((rec[0] & POLL_F_FRESH) &&
+				systick_after_eq(now, ((rec[2] << 8) | rec[3]) + 2 * e->period))
+			{
+				rec[0] &= ~POLL_F_FRESH;
+				cache_dirty = true;
+			}
+
+			// the most overdue entry goes first
+			if (e->len && systick_after_eq(now, e->next_run) &&
+				(int16_t) (now - e->next_run) > late)
+			{
+				late = now - e->next_run;
+				next = i;
+			}
+		}
+
+		if (next < POLL_SLOTS) {
+			poll_entry_t* e = &list[next];
+
+			e->next_run += e->period;
+			if (systick_after_eq(now, e->next_run)) {
+				// overrun, don't try to catch up
+				e->next_run = now + e->period;
+			}
+
+			xfer.addr = e->addr >> 1;
+			xfer_reg = e->reg;
+			xfer.rx_len = e->len;
+			xfer_slot = next;
+		}
+	}
+
+	if (cache_dirty) {
+		poll_publish();
+	}
+
+	if (xfer_slot < POLL_SLOTS) {
+		xfer.tx = &xfer_reg;
+		xfer.tx_len = 1;
+		xfer.rx = xfer_rx;
+		i2c_submit(&xfer);
+	}
+}
+
+static GATE_TASK poll_gate_task = {
+	.task = poll_task,
+	.period = POLL_TASK_PERIOD,
+};
+
+static GATE_RESULT
+poll_i2cadapter_read(uint8_t reg, uint8_t* data, uint8_t* data_len)
+{
+	uint8_t* p = data;
+	static const uint8_t sizes[] = { 6, 5 };
+
+	if (!*data_len) {
+		return GR_OK;
+	}
+
+	if (reg < sizeof(sizes) && *data_len < sizes[reg]) {
+		return GR_INVALID_ARG;
+	}
+
+	switch (reg) {
+		case POLL_CTRL_REG:
+			p = gate_put16(p, SYSTICK_HZ);
+			p = gate_put16(p, systick_get());
+			*p++ = POLL_SLOTS;
+			*p++ = POLL_DATA_LEN;
+			break;
+
+		case POLL_LIST_REG:
+			if (list_num >= POLL_SLOTS) {
+				list_num = 0;
+			}
+			*p++ = list[list_num].addr;
+			*p++ = list[list_num].reg;
+			*p++ = list[list_num].len;
+			p = gate_put16(p, list[list_num].period_ms);
+
+			// next read — next entry
+			++list_num;
+			break;
+
+		default:
+			return GR_NO_ACCESS;
+	}
+
+	*data_len = p - data;
+	return GR_OK;
+}
+
+static GATE_RESULT
+poll_i2cadapter_write(uint8_t reg, uint8_t* data, uint8_t data_len)
+{
+	uint16_t period_ms;
+	uint32_t period;
+
+	switch (reg) {
+		case POLL_CTRL_REG:
+			if (!data_len) {
+				return GR_INVALID_DATA;
+			}
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+				for (uint8_t i=0; i < POLL_SLOTS; i++) {
+					list[i].len = 0;
+				}
+				list_changed = (uint8_t) ((1U << POLL_SLOTS) - 1);
+			}
+			break;
+
+		case POLL_LIST_REG:
+			if (data_len != 1 && data_len != 6) {
+				return GR_INVALID_ARG;
+			}
+			if (data[0] >= POLL_SLOTS) {
+				return GR_INVALID_ARG;
+			}
+			list_num = data[0];
+			if (data_len == 1) {
+				break;
+			}
+
+			period_ms = (data[4] << 8) | data[5];
+			period = SYSTICK_MS(period_ms);
+			if ((data[1] & 1) || data[3] > POLL_DATA_LEN ||
+				!period || period > POLL_PERIOD_MAX)
+			{
+				return GR_INVALID_ARG;
+			}
+
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+				poll_entry_t* e = &list[data[0]];
+
+				e->addr = data[1];
+				e->reg = data[2];
+				e->len = data[3];
+				e->period_ms = period_ms;
+				e->period = period;
+				e->next_run = systick_get();
+				list_changed |= _BV(data[0]);
+			}
+			break;
+
+		default:
+			return GR_NO_ACCESS;
+	}
+
+	return GR_OK;
+}
+
+static GATE_RESULT
+poll_i2cadapter_window(uint8_t reg, const uint8_t** data, uint16_t* data_len)
+{
+	if (reg != POLL_CACHE_REG) {
+		return GR_NO_ACCESS;
+	}
+
+	// don't publish new readings until the transfer ends
+	cache_hold = true;
+	*data = gate_snapshot_front(&cache);
+	*data_len = CACHE_LEN;
+	return GR_OK;
+}
+
+static void poll_i2cadapter_release(uint8_t reg)
+{
+	(void)reg;
+	cache_hold = false;
+}
+
+// Autoload
+I2C_MODULE_INIT(poll_adapter)
+{
+	gate_task_register(&poll_gate_task);
+	gate_i2cadapter_register(&poll_i2cadapter);
+}
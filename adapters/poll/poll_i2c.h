@@ -0,0 +1,103 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** I2C device polling adapter
+ * @file poll_i2c.h
+ */
+
+#ifndef POLL_DRIVER_H
+#define POLL_DRIVER_H
+
+#include "core/common.h"
+
+/**
+ * @ingroup Drivers
+ * @defgroup PollAdapter I2C device polling adapter
+ *
+ * Reads registers of external I2C devices on its own, as the poll list
+ * says, and keeps the last readings in a cache. The host (or another
+ * I2C master) reads the whole cache in one transaction instead of
+ * asking for every device register in turn.
+ *
+ * Each poll is one master transfer: register address write, repeated
+ * START, read of len bytes. Entries are polled one at a time, the
+ * earliest due first. All values are big-endian.
+ *
+ * @{
+ */
+
+#define POLL_UID   0x0070
+#define POLL_MAJOR 1
+#define POLL_MINOR 0
+
+#ifndef POLL_SLOTS
+/** Poll list length (at most 8) */
+#define POLL_SLOTS    8
+#endif
+
+#ifndef POLL_DATA_LEN
+/** Cache bytes per entry */
+#define POLL_DATA_LEN 8
+#endif
+
+/** Control register.
+ * Read: tick rate in Hz (2 bytes), current tick (2 bytes),
+ * POLL_SLOTS, POLL_DATA_LEN.
+ * Write: any (non-empty) data clears the poll list and the cache.
+ */
+#define POLL_CTRL_REG  0x00
+
+/** Poll list.
+ * Write [slot] selects the entry to read; write
+ * [slot][addr][reg][len][period (2 bytes, ms)] sets it: addr is the
+ * 8-bit write address, len is 1..POLL_DATA_LEN, 0 removes the entry.
+ * Read: addr, reg, len, period of the selected entry, then select
+ * the next one. Ends burst reads.
+ */
+#define POLL_LIST_REG  0x01
+
+/** Cache (read window only).
+ * POLL_SLOTS records of POLL_CACHE_REC bytes:
+ * @code
+ * [flags][status][tick (2 bytes)][data (POLL_DATA_LEN bytes)]
+ * @endcode
+ * status is the I2C_E_* code of the last poll, tick is the systick
+ * time of the last good reading. The cache is consistent within one
+ * transaction; new readings are published after it ends.
+ */
+#define POLL_CACHE_REG 0x02
+
+/** Cache record flags
+ * @{
+ */
+#define POLL_F_VALID 0x01 /**< data holds a reading */
+#define POLL_F_FRESH 0x02 /**< reading is less than two periods old */
+#define POLL_F_ERROR 0x04 /**< last poll failed, see status */
+/**@}*/
+
+/** Cache record size */
+#define POLL_CACHE_REC (4 + POLL_DATA_LEN)
+
+/**@}*/
+
+#endif // POLL_DRIVER_H
@@ -0,0 +1,6 @@
+# -*- Makefile -*-
+
+DEFINES += -DHAVE_POLL
+INCLUDE_DIRS += -I${ORFA}/adapters/poll
+
+SRC += ${ORFA}/adapters/poll/poll_i2c.c
@@ -25,6 +25,7 @@
 #include "core/ports.h"
 #include "core/i2cadapter.h"
 #include <avr/io.h>
+#include <util/atomic.h>
 
 #include "ports_i2c.h"
 
@@ -40,15 +41,31 @@ static GATE_PORT ports[] = {
 static GATE_I2CADAPTER ports_i2cadapter = {
 	.uid = GATE_PORT_UID,
 	.major_version = 1,
-	.minor_version = 1,
+	.minor_version = 2,
 	.read = ports_i2cadapter_read,
 	.write = ports_i2cadapter_write,
-	.num_registers = GATE_NUM_PORTS * 2,
+	.num_registers = GATE_NUM_PORTS * 2 + 1,
 };
 
+/// All ports sampled at once, one byte per port
+#define PORTS_FRAME_REG (GATE_NUM_PORTS * 2)
+
 static GATE_RESULT
 ports_i2cadapter_read(uint8_t reg, uint8_t* data, uint8_t* data_len)
 {
+	if (reg == PORTS_FRAME_REG) {
+		uint8_t i;
+		if (*data_len < GATE_NUM_PORTS) {
+			return GR_INVALID_ARG;
+		}
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+			for (i = 0; i < GATE_NUM_PORTS; i++) {
+				data[i] = *(volatile uint8_t*) ports[i].PIN;
+			}
+		}
+		*data_len = GATE_NUM_PORTS;
+		return GR_OK;
+	}
 	if (reg >=  GATE_NUM_PORTS) {
 		return GR_NO_ACCESS;
 	}
@@ -74,6 +91,10 @@ ports_i2cadapter_write(uint8_t reg, uint8_t* data, uint8_t data_len)
 		return GR_OK;
 	}
 
+	if (reg == PORTS_FRAME_REG) {
+		return GR_NO_ACCESS;
+	}
+
 	if (reg >= GATE_NUM_PORTS) {
 		port = reg - GATE_NUM_PORTS;
 	} else {
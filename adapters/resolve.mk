@@ -1,4 +1,8 @@
 # -*- Makefile -*-
 
+ifeq ($(I2C_STATS),yes)
+	ADAPTERS += i2cstats
+endif
+
 include $(foreach adapter,$(sort $(ADAPTERS)), adapters/$(adapter)/resolve.mk)
 
@@ -0,0 +1,5 @@
+# -*- Makefile -*-
+
+INCLUDE_DIRS += -I${ORFA}/adapters/sched
+
+SRC += ${ORFA}/adapters/sched/sched_i2c.c
@@ -0,0 +1,132 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Scheduler statistics I2C adapter
+ * @file sched_i2c.c
+ */
+
+#include "core/i2cadapter.h"
+#include "core/scheduler.h"
+
+#include "sched_i2c.h"
+
+static GATE_RESULT
+sched_i2cadapter_read(uint8_t reg, uint8_t* data, uint8_t* data_len);
+static GATE_RESULT
+sched_i2cadapter_write(uint8_t reg, uint8_t* data, uint8_t data_len);
+
+static GATE_I2CADAPTER sched_i2cadapter = {
+	.uid = SCHED_UID,
+	.major_version = SCHED_MAJOR,
+	.minor_version = SCHED_MINOR,
+	.read = sched_i2cadapter_read,
+	.write = sched_i2cadapter_write,
+	.num_registers = 3,
+	.read_effects = 1 << SCHED_TASK_REG,
+};
+
+static uint8_t task_num;
+
+static GATE_RESULT
+sched_i2cadapter_read(uint8_t reg, uint8_t* data, uint8_t* data_len)
+{
+	GATE_TASK_STATS* st;
+	uint8_t* p = data;
+	static const uint8_t sizes[] = { 8, 2 * GATE_STATS_HIST_LEN, 10 };
+
+	if (!*data_len) {
+		return GR_OK;
+	}
+
+	if (reg < sizeof(sizes) && *data_len < sizes[reg]) {
+		return GR_INVALID_ARG;
+	}
+
+	switch (reg) {
+		case SCHED_CTRL_REG:
+			p = gate_put32(p, gate_sched_stats.idle_cycles);
+			p = gate_put32(p, gate_sched_stats.total_cycles);
+			break;
+
+		case SCHED_HIST_REG:
+			for (uint8_t i=0; i < GATE_STATS_HIST_LEN; i++) {
+				p = gate_put16(p, gate_sched_stats.loop_hist[i]);
+			}
+			break;
+
+		case SCHED_TASK_REG:
+			if (task_num == 0) {
+				st = &gate_sched_stats.super;
+			} else {
+				GATE_TASK* task = gate_task_nth(task_num - 1);
+				if (!task) {
+					task_num = 0;
+					st = &gate_sched_stats.super;
+				} else {
+					st = &task->stats;
+				}
+			}
+			p = gate_put16(p, st->calls);
+			p = gate_put32(p, st->cycles);
+			p = gate_put32(p, st->cycles_max);
+
+			// next read — next task
+			++task_num;
+			break;
+
+		default:
+			return GR_NO_ACCESS;
+	}
+
+	*data_len = p - data;
+	return GR_OK;
+}
+
+static GATE_RESULT
+sched_i2cadapter_write(uint8_t reg, uint8_t* data, uint8_t data_len)
+{
+	switch (reg) {
+		case SCHED_CTRL_REG:
+			gate_sched_stats_reset();
+			break;
+
+		case SCHED_TASK_REG:
+			if (data_len != 1) {
+				return GR_INVALID_ARG;
+			}
+			task_num = *data;
+			break;
+
+		default:
+			return GR_NO_ACCESS;
+	}
+
+	return GR_OK;
+}
+
+// Autoload
+I2C_MODULE_INIT(sched_adapter)
+{
+	gate_i2cadapter_register(&sched_i2cadapter);
+}
+
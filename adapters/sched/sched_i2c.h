@@ -0,0 +1,68 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Scheduler statistics I2C adapter
+ * @file sched_i2c.h
+ */
+
+#ifndef SCHED_DRIVER_H
+#define SCHED_DRIVER_H
+
+#include "core/common.h"
+
+/**
+ * @ingroup Drivers
+ * @defgroup SchedAdapter Scheduler statistics adapter
+ *
+ * Available only with GATE_SCHED_STATS (SCHED_STATS = yes).
+ * All values are big-endian.
+ *
+ * @{
+ */
+
+#define SCHED_UID   0x0010
+#define SCHED_MAJOR 1
+#define SCHED_MINOR 0
+
+/** Control register.
+ * Read: idle cycles (4 bytes), total cycles (4 bytes).
+ * Write: any data resets all statistics.
+ */
+#define SCHED_CTRL_REG  0x00
+
+/** Loop period histogram.
+ * Read: GATE_STATS_HIST_LEN counters, 2 bytes each.
+ */
+#define SCHED_HIST_REG  0x01
+
+/** Task statistics.
+ * Write: select task (0 -- supertask, 1.. -- scheduler ring).
+ * Read: calls (2 bytes), total cycles (4 bytes), max cycles (4 bytes)
+ * of selected task, then select next one. Ends burst reads.
+ */
+#define SCHED_TASK_REG  0x02
+
+/**@}*/
+
+#endif // SCHED_DRIVER_H
+
@@ -29,9 +29,10 @@
  */
 
 #include "servo_i2c.h"
+#include "core/scheduler.h"
 
-//static GATE_RESULT
-//servo_i2cadapter_read(uint8_t reg, uint8_t* data, uint8_t* data_len);
+static GATE_RESULT
+servo_i2cadapter_read(uint8_t reg, uint8_t* data, uint8_t* data_len);
 static GATE_RESULT
 servo_i2cadapter_write(uint8_t reg, uint8_t* data, uint8_t data_len);
 
@@ -39,19 +40,49 @@ static GATE_I2CADAPTER servo_i2cadapter = {
 	.uid = SERVO_UID,
 	.major_version = SERVO_MAJOR,
 	.minor_version = SERVO_MINOR,
-//	.read = servo_i2cadapter_read,
+	.read = servo_i2cadapter_read,
 	.write = servo_i2cadapter_write,
 	.num_registers = 2,
 };
 
-#if 0
+#ifdef HAL_SERVO_NTIM
+/// Servo command iteration period (ITERATION_STEP in servo_cmd_lld.c)
+#define SERVO_TASK_PERIOD SYSTICK_MS(10)
+
+static GATE_TASK servo_task = {
+	.task = servo_loop,
+	.period = SERVO_TASK_PERIOD,
+};
+#endif
+
+/** Read positions of all servos (u16 big endian each)
+ */
 static GATE_RESULT
 servo_i2cadapter_read(uint8_t reg, uint8_t* data, uint8_t* data_len)
 {
-	*data_len = 0;
+	if (reg != SERVO) {
+		return GR_NO_ACCESS;
+	}
+
+	if (!*data_len) {
+		return GR_OK;
+	}
+
+	if (*data_len < SERVO_LEN * 2) {
+		return GR_INVALID_ARG;
+	}
+
+	// copy frame (little endian) and swap bytes in place
+	servo_get_frame(data);
+	for (uint8_t i = 0; i < SERVO_LEN * 2; i += 2) {
+		uint8_t lo = data[i];
+		data[i] = data[i+1];
+		data[i+1] = lo;
+	}
+
+	*data_len = SERVO_LEN * 2;
 	return GR_OK;
 }
-#endif
 
 static GATE_RESULT
 servo_i2cadapter_write(uint8_t reg, uint8_t* data, uint8_t data_len)
@@ -76,11 +107,11 @@ servo_i2cadapter_write(uint8_t reg, uint8_t* data, uint8_t data_len)
 
 	debug("# lev-3\n");
 
-	uint16_t _servo_target[32];
-	uint16_t _servo_maxspeed[32];
+	uint16_t _servo_target[SERVO_LEN];
+	uint16_t _servo_maxspeed[SERVO_LEN];
 	uint16_t _max_time=0;
 
-	for (int i=0; i < 32; i++) {
+	for (int i=0; i < SERVO_LEN; i++) {
 		_servo_target[i] = 0;
 		_servo_maxspeed[i] = 0;
 	}
@@ -89,8 +120,14 @@ servo_i2cadapter_write(uint8_t reg, uint8_t* data, uint8_t data_len)
 		uint16_t val = (data[1]<<8)|data[2];
 		uint8_t id = data[0];
 		if (id < 128) {
+			if (id >= SERVO_LEN) {
+				return GR_INVALID_DATA;
+			}
 			_servo_target[id] = val;
 		} else if (id < 255) {
+			if (id - 128 >= SERVO_LEN) {
+				return GR_INVALID_DATA;
+			}
 			_servo_maxspeed[id-128] = val;
 		} else if (id == 255) {
 			_max_time = val;
@@ -115,6 +152,9 @@ servo_i2cadapter_write(uint8_t reg, uint8_t* data, uint8_t data_len)
 I2C_MODULE_INIT(servo_adapter)
 {
 	servo_init();
+#ifdef HAL_SERVO_NTIM
+	gate_task_register(&servo_task);
+#endif
 	gate_i2cadapter_register(&servo_i2cadapter);
 }
 
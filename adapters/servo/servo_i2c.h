@@ -40,26 +40,26 @@
 
 /// Servo config. NOT USED
 #define SERVO_CONF 0x00
-/// Servo control register
+/// Servo control register (write: command, read: positions)
 #define SERVO 0x01
 
 #ifdef OR_AVR_M128_S
 
 #define SERVO_UID   0x30
 #define SERVO_MAJOR 1
-#define SERVO_MINOR 2
+#define SERVO_MINOR 3
 
 #elif defined(OR_AVR_M32_D)
 
 #define SERVO_UID   0x31
 #define SERVO_MAJOR 1
-#define SERVO_MINOR 1
+#define SERVO_MINOR 2
 
 #elif defined(OR_AVR_M128_DS)
 
 #define SERVO_UID   0x32
 #define SERVO_MAJOR 1
-#define SERVO_MINOR 2
+#define SERVO_MINOR 3
 
 #else
 #error Unsupported platform
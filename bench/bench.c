@@ -0,0 +1,367 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Cycle benchmarks for simulavr
+ * @file bench/bench.c
+ *
+ * Built instead of main.c by `make bench` (see bench/resolve.mk).
+ * The whole firmware is linked in and initialised as usual, then each
+ * hot path is called BENCH_RUNS times with interrupts disabled and
+ * timed with Timer1 running at F_CPU. Call overhead is subtracted.
+ *
+ * Results go to the simulavr pipe register as "name cycles" lines,
+ * bench/compare.awk checks them against bench/baseline/$(PLATFORM).txt.
+ *
+ * The TWI hardware is not modelled by simulavr, so the per-byte cost
+ * of the TWI ISR is measured on the slave handlers it calls.
+ */
+
+#include <stdio.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#define main firmware_main
+#include "main.c"
+#undef main
+
+#include "eterm/eterm.h"
+#include "lib/cbuf.h"
+#include "lib/fmt.h"
+#include "lib/hex.h"
+#ifdef HAVE_ADC
+#include "hal/adc.h"
+#endif
+#ifdef HAVE_SERVO
+#include "hal/servo.h"
+#endif
+
+/// simulavr special registers (-W 0x20,- -e 0x21)
+#define BENCH_PIPE (*(volatile uint8_t*) 0x20)
+#define BENCH_EXIT (*(volatile uint8_t*) 0x21)
+
+#define BENCH_RUNS 64
+
+typedef void (*BENCH_FUNC)(void);
+
+typedef struct {
+	PGM_P name;
+	BENCH_FUNC func;
+} BENCH;
+
+static int bench_putchar(char c, FILE* stream)
+{
+	(void)stream;
+	BENCH_PIPE = c;
+	return 0;
+}
+
+static FILE bench_out = FDEV_SETUP_STREAM(bench_putchar, NULL, _FDEV_SETUP_WRITE);
+
+static int null_putchar(char c, FILE* stream)
+{
+	(void)c;
+	(void)stream;
+	return 0;
+}
+
+/// stdout while measuring: response formatting without the UART
+static FILE bench_null = FDEV_SETUP_STREAM(null_putchar, NULL, _FDEV_SETUP_WRITE);
+
+#define BENCH_NAME(name) static const char name ## _name[] PROGMEM = #name;
+#define BENCH_ENTRY(name) { name ## _name, bench_ ## name }
+
+// -- cases --
+
+static void bench_empty(void)
+{
+}
+
+static void bench_parse_command_first(void)
+{
+	parse_command('S', true);
+}
+BENCH_NAME(parse_command_first)
+
+static void bench_parse_command_char(void)
+{
+	parse_command('0', false);
+}
+BENCH_NAME(parse_command_char)
+
+static GATE_RESULT bench_read(uint8_t reg, uint8_t* data, uint8_t* data_len)
+{
+	*data = reg;
+	*data_len = 1;
+	return GR_OK;
+}
+
+static GATE_RESULT bench_write(uint8_t reg, uint8_t* data, uint8_t data_len)
+{
+	(void)reg;
+	(void)data;
+	(void)data_len;
+	return GR_OK;
+}
+
+static GATE_I2CADAPTER bench_i2cadapter = {
+	.uid = 0xFFBE,
+	.read = bench_read,
+	.write = bench_write,
+	.num_registers = 1,
+};
+
+static void bench_register_read(void)
+{
+	uint8_t len = sizeof(buf);
+	gate_register_read(bench_i2cadapter.start_register, buf, &len);
+}
+BENCH_NAME(register_read)
+
+static void bench_register_write(void)
+{
+	gate_register_write(bench_i2cadapter.start_register, buf, 1);
+}
+BENCH_NAME(register_write)
+
+static void bench_twi_rx_byte(void)
+{
+	// master write, data byte
+	i2c_txc_handler(0x55);
+}
+BENCH_NAME(twi_rx_byte)
+
+static void bench_twi_tx_byte(void)
+{
+	// master read, data byte
+	uint8_t c;
+	bool ack = true;
+	i2c_rxc_handler(&c, &ack);
+}
+BENCH_NAME(twi_tx_byte)
+
+static cbf_t bench_cbf;
+
+static void bench_cbf_put(void)
+{
+	cbf_put(&bench_cbf, 0x55);
+}
+BENCH_NAME(cbf_put)
+
+static void bench_cbf_get(void)
+{
+	cbf_get(&bench_cbf);
+}
+BENCH_NAME(cbf_get)
+
+static void bench_fmt_u16(void)
+{
+	fmt_u16(54321);
+}
+BENCH_NAME(fmt_u16)
+
+static void bench_printf_u16(void)
+{
+	printf_P(PSTR("%u"), 54321);
+}
+BENCH_NAME(printf_u16)
+
+static void bench_fmt_fixed(void)
+{
+	fmt_fixed(330, 2);
+}
+BENCH_NAME(fmt_fixed)
+
+static uint8_t bench_hex_raw[16];
+static char bench_hex_buf[2 * sizeof(bench_hex_raw)];
+
+static void bench_hex_encode(void)
+{
+	hex_encode(bench_hex_buf, bench_hex_raw, sizeof(bench_hex_raw));
+}
+BENCH_NAME(hex_encode)
+
+// decodes what bench_hex_encode() left in the buffer
+static void bench_hex_decode(void)
+{
+	hex_decode(bench_hex_raw, bench_hex_buf, sizeof(bench_hex_raw));
+}
+BENCH_NAME(hex_decode)
+
+#ifdef HAVE_SERVO
+static void bench_servo_set_position(void)
+{
+	servo_set_position(0, 1500);
+}
+BENCH_NAME(servo_set_position)
+
+#if defined(HAL_WITH_SERVO_CMD) && !defined(HAL_SERVO_NTIM)
+#ifndef HAL_SERVO_TIM0
+#define SERVO_CMD_vect SIG_OUTPUT_COMPARE2
+#else
+#define SERVO_CMD_vect SIG_OUTPUT_COMPARE0
+#endif
+void SERVO_CMD_vect(void);
+
+static void bench_servo_cmd_isr(void)
+{
+	SERVO_CMD_vect();
+}
+BENCH_NAME(servo_cmd_isr)
+#endif
+#endif // HAVE_SERVO
+
+#if defined(HAVE_ADC) && !defined(HAL_ADC_NISR)
+void ADC_vect(void);
+
+static void bench_adc_isr(void)
+{
+	ADC_vect();
+}
+BENCH_NAME(adc_isr)
+#endif
+
+static const BENCH benches[] PROGMEM = {
+	BENCH_ENTRY(parse_command_first),
+	BENCH_ENTRY(parse_command_char),
+	BENCH_ENTRY(register_read),
+	BENCH_ENTRY(register_write),
+	BENCH_ENTRY(twi_rx_byte),
+	BENCH_ENTRY(twi_tx_byte),
+	BENCH_ENTRY(cbf_put),
+	BENCH_ENTRY(cbf_get),
+	BENCH_ENTRY(fmt_u16),
+	BENCH_ENTRY(printf_u16),
+	BENCH_ENTRY(fmt_fixed),
+	BENCH_ENTRY(hex_encode),
+	BENCH_ENTRY(hex_decode),
+#ifdef HAVE_SERVO
+	BENCH_ENTRY(servo_set_position),
+#if defined(HAL_WITH_SERVO_CMD) && !defined(HAL_SERVO_NTIM)
+	BENCH_ENTRY(servo_cmd_isr),
+#endif
+#endif
+#if defined(HAVE_ADC) && !defined(HAL_ADC_NISR)
+	BENCH_ENTRY(adc_isr),
+#endif
+};
+
+// -- harness --
+
+/** Run function once
+ * @return Timer1 cycles
+ */
+static uint16_t bench_once(BENCH_FUNC func)
+{
+	uint16_t t;
+
+	TCNT1 = 0;
+	func();
+	t = TCNT1;
+	// ISR entry points return with reti
+	cli();
+	return t;
+}
+
+static uint16_t bench_run(BENCH_FUNC func)
+{
+	uint32_t sum = 0;
+
+	for (uint8_t i=0; i < BENCH_RUNS; i++) {
+		sum += bench_once(func);
+	}
+	return sum / BENCH_RUNS;
+}
+
+/** Stop every interrupt source, keep Timer1 as free running counter
+ */
+static void bench_setup(void)
+{
+#ifdef TIMSK
+	TIMSK = 0;
+#else
+	TIMSK0 = 0;
+	TIMSK1 = 0;
+	TIMSK2 = 0;
+#endif
+#ifdef ETIMSK
+	ETIMSK = 0;
+#endif
+	i2c_lock();
+	ADCSRA &= ~_BV(ADIE);
+	stdout = &bench_null;
+
+	TCCR1A = 0;
+	TCCR1B = _BV(CS10);
+}
+
+/** Put state where the measured path does real work
+ */
+static void bench_prepare(void)
+{
+	gate_i2cadapter_register(&bench_i2cadapter);
+	cbf_init(&bench_cbf);
+
+	// slave receiver after the register byte
+	state_i2c = GET_DATA;
+	// slave transmitter streaming from a long read buffer
+	read_ptr = buf;
+	read_len = BENCH_RUNS;
+
+#if defined(HAVE_SERVO) && defined(HAL_WITH_SERVO_CMD)
+	{
+		// long move on every servo: each iteration interpolates all
+		uint16_t target[SERVO_LEN];
+		uint16_t maxspeed[SERVO_LEN];
+		for (uint8_t i=0; i < SERVO_LEN; i++) {
+			target[i] = 2000;
+			maxspeed[i] = 0;
+		}
+		servo_command(60000, target, maxspeed);
+	}
+#endif
+}
+
+int main(void)
+{
+	uint16_t overhead;
+
+	cli();
+	bench_setup();
+	bench_prepare();
+
+	overhead = bench_run(bench_empty);
+
+	for (uint8_t i=0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+		PGM_P name = (PGM_P) pgm_read_word(&benches[i].name);
+		BENCH_FUNC func = (BENCH_FUNC) pgm_read_word(&benches[i].func);
+		uint16_t cycles = bench_run(func) - overhead;
+
+		fputs_P(name, &bench_out);
+		fprintf_P(&bench_out, PSTR(" %u\n"), cycles);
+	}
+
+	BENCH_EXIT = 0;
+	for (;;);
+	return 0;
+}
@@ -0,0 +1,60 @@
+# Compare benchmark results with baseline
+#
+# usage: awk -v baseline=FILE -v tolerance=PERCENT -f compare.awk RESULT
+#
+# Both files hold "name cycles" lines, '#' starts a comment.
+# Exit status is 1 if any result exceeds its baseline by more than
+# tolerance percent, if the baseline has no entries (record it with
+# make bench_baseline), or if a result has no baseline entry or the
+# other way round.
+
+BEGIN {
+	if (tolerance == "")
+		tolerance = 5
+	nbase = 0
+	if (baseline != "") {
+		while ((getline line < baseline) > 0) {
+			if (line ~ /^[a-z_0-9]+ [0-9]+$/) {
+				split(line, f, " ")
+				base[f[1]] = f[2]
+				nbase++
+			}
+		}
+	}
+	if (!nbase) {
+		printf "no baseline entries in '%s', run make bench_baseline\n", baseline
+		exit 1
+	}
+	failed = 0
+	printf "%-24s %8s %8s %8s\n", "bench", "baseline", "cycles", "delta"
+}
+
+/^[a-z_0-9]+ [0-9]+$/ {
+	name = $1
+	cycles = $2
+	seen[name] = 1
+	if (!(name in base)) {
+		printf "%-24s %8s %8d %8s\n", name, "-", cycles, "  NO BASELINE"
+		failed = 1
+		next
+	}
+	delta = base[name] ? (cycles - base[name]) * 100.0 / base[name] : 0
+	mark = ""
+	if (cycles > base[name] * (100 + tolerance) / 100) {
+		mark = "  REGRESSION"
+		failed = 1
+	}
+	printf "%-24s %8d %8d %+7.1f%%%s\n", name, base[name], cycles, delta, mark
+}
+
+END {
+	if (!nbase)
+		exit 1
+	for (name in base) {
+		if (!(name in seen)) {
+			printf "%-24s %8d %8s %8s\n", name, base[name], "-", "  NO RESULT"
+			failed = 1
+		}
+	}
+	exit failed
+}
@@ -0,0 +1,10 @@
+# -*- Makefile -*-
+# Benchmark image (BENCH=yes, see `make bench` in debug.mk):
+# bench/bench.c replaces main.c, everything else is the usual firmware.
+
+ifeq ($(PLATFORM),HOST_SIM)
+    $(error cycle benchmarks need an AVR platform, use `make -C core bench` on host)
+endif
+
+target = ${ORFA}/bench/orfa_bench
+SRC := $(filter-out main.c,$(SRC)) ${ORFA}/bench/bench.c
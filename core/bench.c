@@ -0,0 +1,226 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Host benchmark for core
+ * @file core/bench.c
+ *
+ * Build and run: make -C core bench
+ *
+ * The ref_ cases dispatch through the old adapter list walk, for
+ * comparison with register_map.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "i2cadapter.h"
+
+#define NUM_ADAPTERS   8
+#define REGS_PER_ADAPTER 4
+#define ITERATIONS     10000000UL
+
+static GATE_RESULT bench_read(uint8_t reg, uint8_t* data, uint8_t* data_len)
+{
+	*data = reg;
+	*data_len = 1;
+	return GR_OK;
+}
+
+static GATE_RESULT bench_write(uint8_t reg, uint8_t* data, uint8_t data_len)
+{
+	(void)reg;
+	(void)data;
+	(void)data_len;
+	return GR_OK;
+}
+
+static GATE_I2CADAPTER adapters[NUM_ADAPTERS];
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// -- list walk reference, as in core/i2cadapter.c before register_map --
+
+typedef struct ref_adapter_ {
+	GATE_READ read;
+	GATE_WRITE write;
+	uint8_t start_register;
+	uint8_t num_registers;
+	struct ref_adapter_* next;
+} ref_adapter;
+
+static ref_adapter ref_nodes[NUM_ADAPTERS + 1];
+static ref_adapter* ref_adapters;
+
+/// old gate_i2cadapter_register(): the newest adapter is the list head
+static void ref_register(const GATE_I2CADAPTER* adapter, ref_adapter* node)
+{
+	node->read = adapter->read;
+	node->write = adapter->write;
+	node->start_register = adapter->start_register;
+	node->num_registers = adapter->num_registers;
+	node->next = ref_adapters;
+	ref_adapters = node;
+}
+
+static __attribute__((noinline)) ref_adapter* ref_find_adapter(uint8_t reg)
+{
+	ref_adapter* adapter = ref_adapters;
+	while (adapter) {
+		uint8_t num = adapter->num_registers;
+		uint8_t start = adapter->start_register;
+		if ((reg >= start) && (reg < start+num)) {
+			return adapter;
+		}
+		adapter = adapter->next;
+	}
+	return 0;
+}
+
+static GATE_RESULT ref_register_read(uint8_t reg, uint8_t* data, uint8_t* data_len)
+{
+	ref_adapter* adapter = ref_find_adapter(reg);
+	if (adapter) {
+		if (!adapter->read) {
+			return GR_NO_ACCESS;
+		}
+		return adapter->read((reg - adapter->start_register), data, data_len);
+	}
+	return GR_INVALID_REGISTER;
+}
+
+static GATE_RESULT ref_register_write(uint8_t reg, uint8_t* data, uint8_t data_len)
+{
+	ref_adapter* adapter = ref_find_adapter(reg);
+	if (adapter) {
+		if (!adapter->write) {
+			return GR_NO_ACCESS;
+		}
+		return adapter->write((reg - adapter->start_register), data, data_len);
+	}
+	return GR_INVALID_REGISTER;
+}
+
+int main(int argc, char *argv[])
+{
+	uint8_t buf[8];
+	uint8_t len;
+	uint8_t first = 0xFF, last = 0;
+	unsigned long errors = 0;
+	volatile uint8_t sink = 0;
+	double t;
+
+	(void)argc;
+	(void)argv;
+
+	gate_init_introspection();
+	// introspection is registered first: the list tail
+	ref_nodes[NUM_ADAPTERS].read = bench_read;
+	ref_nodes[NUM_ADAPTERS].write = bench_write;
+	ref_nodes[NUM_ADAPTERS].num_registers = 1;
+	ref_adapters = ref_nodes + NUM_ADAPTERS;
+	for (int i=0; i < NUM_ADAPTERS; i++) {
+		adapters[i].uid = 0xFF00 + i;
+		adapters[i].read = bench_read;
+		adapters[i].write = bench_write;
+		adapters[i].num_registers = REGS_PER_ADAPTER;
+		if (gate_i2cadapter_register(adapters + i) != GR_OK) {
+			printf("register failed\n");
+			return EXIT_FAILURE;
+		}
+		ref_register(adapters + i, ref_nodes + i);
+		if (adapters[i].start_register < first)
+			first = adapters[i].start_register;
+		if (adapters[i].start_register + REGS_PER_ADAPTER - 1 > last)
+			last = adapters[i].start_register + REGS_PER_ADAPTER - 1;
+	}
+
+	t = now();
+	for (unsigned long i=0; i < ITERATIONS; i++) {
+		uint8_t reg = first + i % (last - first + 1);
+		len = sizeof(buf);
+		if (gate_register_read(reg, buf, &len) != GR_OK)
+			errors++;
+		sink += buf[0];
+	}
+	t = now() - t;
+	printf("gate_register_read:  %.1f M/s (%d adapters)\n",
+			ITERATIONS / t * 1e-6, NUM_ADAPTERS + 1);
+
+	t = now();
+	for (unsigned long i=0; i < ITERATIONS; i++) {
+		uint8_t reg = first + i % (last - first + 1);
+		if (gate_register_write(reg, buf, 1) != GR_OK)
+			errors++;
+	}
+	t = now() - t;
+	printf("gate_register_write: %.1f M/s (%d adapters)\n",
+			ITERATIONS / t * 1e-6, NUM_ADAPTERS + 1);
+
+	t = now();
+	for (unsigned long i=0; i < ITERATIONS; i++) {
+		uint8_t reg = first + i % (last - first + 1);
+		len = sizeof(buf);
+		if (ref_register_read(reg, buf, &len) != GR_OK)
+			errors++;
+		sink += buf[0];
+	}
+	t = now() - t;
+	printf("ref_register_read:   %.1f M/s (list walk)\n",
+			ITERATIONS / t * 1e-6);
+
+	t = now();
+	for (unsigned long i=0; i < ITERATIONS; i++) {
+		uint8_t reg = first + i % (last - first + 1);
+		if (ref_register_write(reg, buf, 1) != GR_OK)
+			errors++;
+	}
+	t = now() - t;
+	printf("ref_register_write:  %.1f M/s (list walk)\n",
+			ITERATIONS / t * 1e-6);
+
+	// count adapters, then walk the list (wraps around)
+	buf[0] = 0;
+	gate_register_write(0, buf, 1);
+	buf[0] = 1;
+	gate_register_write(0, buf, 1);
+	t = now();
+	for (unsigned long i=0; i < ITERATIONS; i++) {
+		len = sizeof(buf);
+		gate_register_read(0, buf, &len);
+		sink += buf[0];
+	}
+	t = now() - t;
+	printf("introspection read:  %.1f M/s\n", ITERATIONS / t * 1e-6);
+
+	if (errors) {
+		printf("%lu errors\n", errors);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
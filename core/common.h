@@ -48,11 +48,19 @@
 	#endif
 #endif
 
+#ifdef HOST_SIM
+// host simulator: no .initN sections, run from constructors
+#define MODULE_INIT(name) \
+	void init_ ## name ## _module(void) \
+	__attribute__((constructor(108))); \
+	void init_ ## name ## _module(void)
+#else
 #define MODULE_INIT(name) \
 	void init_ ## name ## _module(void) \
 	__attribute__((naked)); \
 	__attribute__((section (".init8"))) \
 	void init_ ## name ## _module(void)
+#endif
 
 #define I2C_MODULE_INIT(name) \
 	MODULE_INIT(i2c_ ## name)
@@ -60,10 +68,16 @@
 #define PARSER_MODULE_INIT(name) \
 	MODULE_INIT(parser_ ## name)
 
+#ifdef HOST_SIM
+#define SYSTEM_INIT() void init_system(void) \
+	__attribute__ ((constructor(107))); \
+	void init_system(void)
+#else
 #define SYSTEM_INIT() void init_system(void) \
 	__attribute__ ((naked)) \
 	__attribute__ ((section (".init7"))); \
 	void init_system(void)
+#endif
 
 
 /**
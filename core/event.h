@@ -0,0 +1,68 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Scheduler events
+ * @file event.h
+ */
+
+#ifndef GATE_EVENT_H
+#define GATE_EVENT_H
+
+#include <stdint.h>
+
+/**
+ * @addtogroup Sheduler
+ *
+ * События выставляются обработчиками прерываний вызовом
+ * gate_event_post_isr(). Задача с ненулевой маской событий вызывается
+ * только на том проходе кольца, в котором было выставлено одно из ее
+ * событий (или по периоду, если он задан). Если за целый проход кольца
+ * ни одна задача не была вызвана и новых событий нет, планировщик
+ * усыпляет процессор до следующего прерывания.
+ *
+ * @{
+ */
+
+#define GATE_EVT_SERIAL  (1 << 0) /**< Принят байт по UART */
+#define GATE_EVT_I2C     (1 << 1) /**< Завершена транзакция I2C (slave) */
+#define GATE_EVT_ADC     (1 << 2) /**< Завершено преобразование АЦП */
+#define GATE_EVT_SERVO   (1 << 3) /**< Шаг интерполяции сервоприводов */
+#define GATE_EVT_I2C_MASTER (1 << 4) /**< Завершена транзакция I2C (master) */
+
+/** Флаги ожидающих событий
+ */
+extern volatile uint8_t gate_events;
+
+/** Выставить событие из обработчика прерывания
+ */
+#define gate_event_post_isr(evt) \
+	do { gate_events |= (evt); } while (0)
+
+/** Выставить событие из основного цикла
+ */
+void gate_event_post(uint8_t evt);
+
+/**@}*/
+
+#endif // GATE_EVENT_H
+
@@ -28,20 +28,22 @@
 #define RESERVED_REGISTERS 2
 
 static uint8_t free_register = RESERVED_REGISTERS;
-static GATE_I2CADAPTER* i2cadapters;
 
-static GATE_I2CADAPTER* find_adapter(uint8_t reg)
+// adapters in registration order
+static GATE_I2CADAPTER* i2cadapters[GATE_MAX_I2CADAPTERS];
+static uint8_t num_i2cadapters;
+
+// register -> adapter index + 1 (0 -- no adapter)
+static uint8_t register_map[GATE_MAX_REGISTERS];
+
+static inline GATE_I2CADAPTER* find_adapter(uint8_t reg)
 {
-	GATE_I2CADAPTER* adapter = i2cadapters;
-	while (adapter) {
-		uint8_t num = adapter->num_registers;
-		uint8_t start = adapter->start_register;
-		if ((reg >= start) && (reg < start+num)) {
-			return adapter;
-		}
-		adapter = adapter->next;
+	uint8_t idx;
+	if (reg >= GATE_MAX_REGISTERS) {
+		return 0;
 	}
-	return 0;
+	idx = register_map[reg];
+	return idx ? i2cadapters[idx - 1] : 0;
 }
 
 static uint8_t gate_allocate_registers(uint8_t count)
@@ -50,7 +52,7 @@ static uint8_t gate_allocate_registers(uint8_t count)
 	if (!free_register) {
 		return 0;
 	}
-	if (!(free_register + count)) {
+	if (free_register + count > GATE_MAX_REGISTERS) {
 		return 0;
 	}
 	reg = free_register;
@@ -82,12 +84,88 @@ GATE_RESULT gate_register_write(uint8_t reg, uint8_t* data, uint8_t data_len)
 	return GR_INVALID_REGISTER;
 }
 
+GATE_RESULT gate_register_window(uint8_t reg, const uint8_t** data, uint16_t* data_len)
+{
+	GATE_I2CADAPTER* adapter = find_adapter(reg);
+	if (adapter) {
+		if (!adapter->window) {
+			return GR_NO_ACCESS;
+		}
+		return adapter->window((reg - adapter->start_register), data, data_len);
+	}
+	return GR_INVALID_REGISTER;
+}
+
+void gate_register_window_release(uint8_t reg)
+{
+	GATE_I2CADAPTER* adapter = find_adapter(reg);
+	if (adapter && adapter->release) {
+		adapter->release(reg - adapter->start_register);
+	}
+}
+
+GATE_RESULT gate_register_read_burst(uint8_t reg, uint8_t* data, uint8_t* data_len)
+{
+	uint8_t left = *data_len;
+	uint8_t* p = data;
+
+	while (reg < free_register && left > 1) {
+		uint8_t len = left - 1;
+		GATE_I2CADAPTER* adapter = find_adapter(reg);
+		uint8_t n = adapter ? reg - adapter->start_register : 0;
+
+		// don't move cursors behind the master's back
+		if (p != data && n < 8 && adapter &&
+			(adapter->read_effects & (1 << n))) {
+			break;
+		}
+		if (gate_register_read(reg, p + 1, &len) != GR_OK) {
+			len = 0;
+		}
+		*p = len;
+		p += len + 1;
+		left -= len + 1;
+		reg++;
+	}
+
+	*data_len = p - data;
+	return GR_OK;
+}
+
+GATE_RESULT gate_register_write_burst(uint8_t reg, uint8_t* data, uint8_t data_len)
+{
+	GATE_RESULT res = GR_OK;
+
+	while (data_len) {
+		uint8_t len = *data++;
+		data_len--;
+		if (len > data_len) {
+			return GR_INVALID_DATA;
+		}
+		if (len) {
+			GATE_RESULT r = gate_register_write(reg, data, len);
+			if (r != GR_OK) {
+				res = r;
+			}
+		}
+		data += len;
+		data_len -= len;
+		reg++;
+	}
+
+	return res;
+}
+
 GATE_RESULT gate_i2cadapter_register(GATE_I2CADAPTER* adapter)
 {
 	uint8_t num = adapter->num_registers;
 	uint8_t reg = 0x00;
 	GATE_RESULT res = GR_OK;
 
+	if (num_i2cadapters >= GATE_MAX_I2CADAPTERS) {
+		return GR_ALLOCATE_REGISTER;
+	}
+
 	if (adapter->uid) {
 		// if not introspection UID
 		// allocate registers
@@ -97,8 +175,10 @@ GATE_RESULT gate_i2cadapter_register(GATE_I2CADAPTER* adapter)
 		}
 	}
 	adapter->start_register = reg;
-	adapter->next = i2cadapters;
-	i2cadapters = adapter;
+	i2cadapters[num_i2cadapters++] = adapter;
+	while (num--) {
+		register_map[reg++] = num_i2cadapters;
+	}
 	return res;
 }
 
@@ -114,6 +194,7 @@ static GATE_I2CADAPTER intro_i2cadapter = {
 	.read = intro_read,
 	.write = intro_write,
 	.num_registers = 1,
+	.read_effects = 0x01, // driver list cursor
 };
 
 static uint8_t intro_num = 0;
@@ -136,13 +217,14 @@ static GATE_RESULT intro_read(uint8_t reg, uint8_t* data, uint8_t* data_len)
 		return GR_OK;
 	}
 
-	*data_len = 6;
-	GATE_I2CADAPTER* adapter = i2cadapters;
-	uint8_t i=intro_num;
-	while (--i) {
-		adapter = adapter->next;
+	if (*data_len < 6) {
+		return GR_INVALID_ARG;
 	}
 
+	*data_len = 6;
+	// last registered first
+	GATE_I2CADAPTER* adapter = i2cadapters[intro_len - intro_num];
+
 	uint16_t uid = adapter->uid;
 	data[0] = (uint8_t) (uid >> 8);
 	data[1] = (uint8_t) uid;
@@ -165,12 +247,7 @@ static GATE_RESULT intro_write(uint8_t reg, uint8_t* data, uint8_t data_len)
 	}
 
 	if (*data == 0) {
-		GATE_I2CADAPTER* adapter = i2cadapters;
-		intro_len = 0;
-		while (adapter) {
-			++intro_len;
-			adapter = adapter->next;
-		}
+		intro_len = num_i2cadapters;
 	}
 
 	if (*data > intro_len) {
@@ -53,6 +53,29 @@
 
 /**@{*/
 
+#ifndef GATE_MAX_REGISTERS
+/** Размер таблицы регистров.
+ * Таблица «регистр → драйвер» строится при регистрации драйверов,
+ * поэтому поиск драйвера по номеру регистра выполняется за постоянное
+ * время. Номера регистров не могут быть больше GATE_REG_MASK (старшие
+ * биты адреса — флаги GATE_REG_READ_ALWAYS и GATE_REG_BURST).
+ */
+#define GATE_MAX_REGISTERS 64
+#endif
+
+/** Флаги адреса регистра в транзакции I2C
+ * @{
+ */
+#define GATE_REG_READ_ALWAYS 0x80 /**< Читать регистр при каждом повторном старте */
+#define GATE_REG_BURST       0x40 /**< Пакетный режим, см. gate_register_read_burst() */
+#define GATE_REG_MASK        0x3F /**< Номер регистра */
+/**@}*/
+
+#ifndef GATE_MAX_I2CADAPTERS
+/** Максимальное количество драйверов (включая драйвер интроспекции) */
+#define GATE_MAX_I2CADAPTERS 16
+#endif
+
 /** Прототип функции чтения данных из драйвера.
  * Драйвер, реализующий чтение из
  * регистров, должен предоставлять функцию типа GATE_READ. Прочитанные данные
@@ -65,6 +88,9 @@
  * @param[out] data_len Указатель на переменную, значение которй
  *                      задает количество байт для чтения.
  *
+ * @note Драйвер не должен записывать в буфер больше *data_len байт.
+ *       Если ответ не помещается в буфер, функция возвращает GR_INVALID_ARG.
+ *
  * @return GR_OK - если данные успешно прочитаны. Иначе - код ошибки. Функция
  * должна возвращать GR_NO_ACCESS, если чтение из запрошенного регистра не
  * поддерживается.
@@ -85,6 +111,31 @@ typedef GATE_RESULT (*GATE_READ)(uint8_t reg, uint8_t* data, uint8_t* data_len);
  */
 typedef GATE_RESULT (*GATE_WRITE)(uint8_t reg, uint8_t* data, uint8_t data_len);
 
+/** Прототип функции окна чтения.
+ * Драйвер может предоставить для регистра «окно» — указатель и длину
+ * данных, которые ведомый передатчик I2C отдает напрямую, без копирования
+ * в промежуточный буфер и без ограничения его размером.
+ *
+ * Функция вызывается из обработчика прерывания TWI. С момента открытия
+ * окна и до вызова GATE_WINDOW_RELEASE драйвер должен сохранять данные
+ * согласованными (например, не обновлять их из своих прерываний).
+ *
+ * @param[in]  reg Номер регистра.
+ * @param[out] data Указатель на данные окна.
+ * @param[out] data_len Длина окна в байтах.
+ *
+ * @return GR_OK, если окно открыто. GR_NO_ACCESS, если для регистра окна
+ *         нет — тогда используется обычное чтение GATE_READ.
+ */
+typedef GATE_RESULT (*GATE_WINDOW)(uint8_t reg, const uint8_t** data, uint16_t* data_len);
+
+/** Прототип функции закрытия окна чтения.
+ * Вызывается по окончании транзакции, в которой было открыто окно.
+ *
+ * @param[in] reg Номер регистра.
+ */
+typedef void (*GATE_WINDOW_RELEASE)(uint8_t reg);
+
 /** Конфигурация драйвера устройств.
  */
 typedef struct GATE_I2CADAPTER_ GATE_I2CADAPTER;
@@ -96,14 +147,18 @@ struct GATE_I2CADAPTER_ {
 	GATE_WRITE write;        /**< Функция записи */
 	uint8_t start_register;  /**< Начальный регистр, из диапазона регистров обслуживаемых драйвером */
 	uint8_t  num_registers;  /**< Количество регистров */
-
-	struct GATE_I2CADAPTER_* next; /*<< Указатель на следующий драйвер в списке */
+	GATE_WINDOW window;      /**< Функция окна чтения (необязательно) */
+	GATE_WINDOW_RELEASE release; /**< Закрытие окна чтения (необязательно) */
+	uint8_t read_effects;    /**< Регистры, чтение которых меняет состояние
+	                              драйвера (бит n — регистр n, например,
+	                              курсор); пакетное чтение на них
+	                              останавливается */
 };
 
 /** Регистрирует драйвер устройства.
  * @param[in] driver Указатель на структуру с описанием драйвера
- * @return GR_OK, если драйвер был успешно добавлен. GR_DUPLICATE_REGISTER,
- *         если один из регистров уже используется другим драйвером.Если 
+ * @return GR_OK, если драйвер был успешно добавлен. GR_ALLOCATE_REGISTER,
+ *         если не хватает регистров или места в таблице драйверов. Если 
  *         драйвер предоставляетт функцию инициализации, возможны и другие
  *         значения. Любое значение, отличное от GR_OK, означает, что драйвер
  *         не был добавлен, и использовать его регистры невозможно.
@@ -139,6 +194,75 @@ GATE_RESULT gate_register_read(uint8_t reg, uint8_t* data, uint8_t* data_len);
  */
 GATE_RESULT gate_register_write(uint8_t reg, uint8_t* data, uint8_t data_len);
 
+/** Открытие окна чтения регистра.
+ * @param[in]  reg Номер регистра
+ * @param[out] data Указатель на данные окна
+ * @param[out] data_len Длина окна в байтах
+ * @return GR_INVALID_REGISTER - если для указанного регистра нет
+ *         зарегистрированного драйвера. GR_NO_ACCESS - если драйвер не
+ *         предоставляет окно для этого регистра. Иначе - результат
+ *         выполнения функции окна драйвера.
+ *
+ * @see GATE_WINDOW
+ */
+GATE_RESULT gate_register_window(uint8_t reg, const uint8_t** data, uint16_t* data_len);
+
+/** Закрытие окна чтения регистра.
+ * @param[in] reg Номер регистра, окно которого было открыто
+ *            gate_register_window().
+ */
+void gate_register_window_release(uint8_t reg);
+
+/** Пакетное чтение.
+ * Читает регистры подряд, начиная с reg, переходя от драйвера к драйверу,
+ * пока есть место в буфере. Результат каждого регистра записывается
+ * как байт длины и данные; регистр без доступа на чтение дает нулевую
+ * длину.
+ *
+ * Чтение не меняет состояние устройств: пакет заканчивается перед
+ * регистром, отмеченным в read_effects его драйвера (курсоры
+ * интроспекции, канала АЦП и т. п.). Сам регистр reg читается всегда.
+ *
+ * @param[in]  reg Номер первого регистра
+ * @param[out] data Указатель на буфер данных
+ * @param[out] data_len Размер буфера; на выходе — количество записанных байт.
+ * @return GR_OK
+ */
+GATE_RESULT gate_register_read_burst(uint8_t reg, uint8_t* data, uint8_t* data_len);
+
+/** Пакетная запись.
+ * Данные — последовательность записей «байт длины, данные», которые
+ * записываются в регистры подряд, начиная с reg. Запись нулевой длины
+ * пропускает регистр.
+ *
+ * @param[in] reg Номер первого регистра
+ * @param[in] data Указатель на массив с данными.
+ * @param[in] data_len Количество байт.
+ * @return GR_INVALID_DATA, если запись выходит за конец данных. Иначе —
+ *         последний код ошибки записи в регистр или GR_OK.
+ */
+GATE_RESULT gate_register_write_burst(uint8_t reg, uint8_t* data, uint8_t data_len);
+
+/** Запись 16-битного значения в буфер, старшим байтом вперед
+ * (порядок байт всех регистров).
+ * @return Указатель на байт после записанного значения
+ */
+static inline uint8_t* gate_put16(uint8_t* data, uint16_t val)
+{
+	*data++ = val >> 8;
+	*data++ = val;
+	return data;
+}
+
+/** Запись 32-битного значения в буфер, старшим байтом вперед.
+ * @return Указатель на байт после записанного значения
+ */
+static inline uint8_t* gate_put32(uint8_t* data, uint32_t val)
+{
+	data = gate_put16(data, val >> 16);
+	return gate_put16(data, val);
+}
+
 /**@}*/
 
 /** Инициализация драйвера интроспекции
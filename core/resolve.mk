@@ -1,9 +1,15 @@
 # -*- Makefile -*-
 
 CORELIB_TARGET = core/libcore.a
-CORELIB_SRC = $(filter-out ${ORFA}/core/test.c,$(wildcard ${ORFA}/core/*.c))
+CORELIB_SRC = $(filter-out ${ORFA}/core/test.c ${ORFA}/core/bench.c,$(wildcard ${ORFA}/core/*.c))
 CORELIB_OBJS = $(patsubst %.S,%.o,$(patsubst %.c,%.o,$(patsubst %.cpp,%.o,$(CORELIB_SRC))))
 
 LIBS += $(CORELIB_TARGET)
 LIBS_RULES += $(CORELIB_TARGET)($(CORELIB_OBJS))
+HAL += systick
+
+ifeq ($(SCHED_STATS),yes)
+	DEFINES += -DGATE_SCHED_STATS
+	ADAPTERS += sched
+endif
 #DEFINES +=
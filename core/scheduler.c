@@ -26,20 +26,130 @@
 #include "scheduler.h"
 #include <stdint.h>
 #include "wdt_ext.h"
+#include "hal/systick.h"
+
+#ifdef GATE_SCHED_STATS
+#include <string.h>
+#endif
+
+#if defined(DEBUG) && DEBUG == 2
+// host build: no interrupts, no sleep
+#define ATOMIC_BLOCK(type) for (uint8_t __todo = 1; __todo; __todo = 0)
+#define scheduler_idle()
+#else
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+#endif
+
+volatile uint8_t gate_events;
 
 static GATE_TASK* tasks;
+static GATE_TASK* ring_head;
 static GATE_TASK_FUNC supertask;
+static uint8_t supertask_events;
+static uint8_t cycle_events;
+static bool busy;
+static bool have_polled;
+
+#ifdef GATE_SCHED_STATS
+GATE_SCHEDULER_STATS gate_sched_stats;
+static uint32_t last_step;
+
+static void stats_run(GATE_TASK_STATS* st, GATE_TASK_FUNC func)
+{
+	uint32_t start = systick_cycles();
+	func();
+	uint32_t end = systick_cycles();
+
+	st->calls++;
+	if (end < start) {
+		// cycle counter wrapped, skip sample
+		return;
+	}
+	end -= start;
+	st->cycles += end;
+	if (end > st->cycles_max) {
+		st->cycles_max = end;
+	}
+}
+
+static void stats_loop(void)
+{
+	uint32_t now = systick_cycles();
+	uint32_t period;
+	uint8_t i = 0;
+
+	if (now < last_step) {
+		// cycle counter wrapped, skip sample
+		last_step = now;
+		return;
+	}
+	period = now - last_step;
+	last_step = now;
+	gate_sched_stats.total_cycles += period;
+
+	period >>= 8;
+	while (period && i < GATE_STATS_HIST_LEN - 1) {
+		period >>= 1;
+		i++;
+	}
+	if (gate_sched_stats.loop_hist[i] != 0xFFFF) {
+		gate_sched_stats.loop_hist[i]++;
+	}
+}
+
+GATE_TASK* gate_task_nth(uint8_t n)
+{
+	GATE_TASK* task = ring_head;
+
+	if (!task) {
+		return NULL;
+	}
+	while (n--) {
+		task = task->next;
+		if (task == ring_head) {
+			return NULL;
+		}
+	}
+	return task;
+}
+
+void gate_sched_stats_reset(void)
+{
+	GATE_TASK* task = ring_head;
+
+	memset(&gate_sched_stats, 0, sizeof(gate_sched_stats));
+	while (task) {
+		memset(&task->stats, 0, sizeof(task->stats));
+		task = task->next;
+		if (task == ring_head) {
+			break;
+		}
+	}
+	last_step = systick_cycles();
+}
+
+#define RUN_TASK(st, func)  stats_run(st, func)
+#else
+#define RUN_TASK(st, func)  func()
+#endif
 
 GATE_RESULT gate_task_register(GATE_TASK* task)
 {
 	if (!tasks) {
 		tasks = task;
 		tasks->next = task;
+		ring_head = task;
 	}
 
 	task->next = tasks->next;
 	tasks->next = task;
 
+	if (!task->period && !task->events) {
+		have_polled = true;
+	}
+
 	return GR_OK;
 }
 
@@ -50,26 +160,140 @@ GATE_RESULT gate_supertask_register(GATE_TASK_FUNC task)
 	return GR_OK;
 }
 
+void gate_supertask_set_events(uint8_t events)
+{
+	supertask_events = events;
+}
+
+void gate_event_post(uint8_t evt)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		gate_events |= evt;
+	}
+}
+
+#if !defined(DEBUG) || DEBUG != 2
+/* Sleep until next interrupt.
+ * sei; sleep — the instruction after sei is always executed,
+ * so an event posted right before sleep can't be lost.
+ */
+static void scheduler_idle(void)
+{
+#ifdef GATE_SCHED_STATS
+	uint32_t start = systick_cycles();
+#endif
+
+	cli();
+	if (!gate_events) {
+		sleep_enable();
+		sei();
+		sleep_cpu();
+		sleep_disable();
+	}
+	sei();
+
+#ifdef GATE_SCHED_STATS
+	uint32_t end = systick_cycles();
+	if (end >= start) {
+		gate_sched_stats.idle_cycles += end - start;
+	}
+#endif
+}
+#endif
+
+static bool task_is_ready(GATE_TASK* task)
+{
+	systick_t now;
+
+	if (task->events & cycle_events) {
+		return true;
+	}
+
+	if (task->period) {
+		now = systick_get();
+		if (systick_after_eq(now, task->next_run)) {
+			task->next_run += task->period;
+			if (systick_after_eq(now, task->next_run)) {
+				// overrun, don't try to catch up
+				task->next_run = now + task->period;
+			}
+			return true;
+		}
+		return false;
+	}
+
+	return !task->events;
+}
+
+bool gate_scheduler_step(void)
+{
+#ifdef GATE_SCHED_STATS
+	stats_loop();
+#endif
+
+	if (!tasks || tasks == ring_head) {
+		// new revolution
+		if (!busy && !have_polled && supertask_events) {
+			scheduler_idle();
+		}
+		busy = false;
+
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+			cycle_events = gate_events & ~supertask_events;
+			gate_events &= supertask_events;
+		}
+	}
+
+	if (supertask) {
+		if (!supertask_events) {
+			RUN_TASK(&gate_sched_stats.super, supertask);
+		} else if (gate_events & supertask_events) {
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+				gate_events &= ~supertask_events;
+			}
+			RUN_TASK(&gate_sched_stats.super, supertask);
+			busy = true;
+		}
+	}
+
+	if (!tasks) {
+		return true;
+	}
+
+	if (task_is_ready(tasks)) {
+		busy = true;
+		if (tasks->task) {
+			RUN_TASK(&tasks->stats, tasks->task);
+		}
+	}
+
+	if (!tasks->next) {
+		// error!
+		return false;
+	}
+
+	tasks = tasks->next;
+	return true;
+}
+
 void gate_scheduler_loop(void)
 {
+	systick_init();
+#if !defined(DEBUG) || DEBUG != 2
+	set_sleep_mode(SLEEP_MODE_IDLE);
+#endif
 	wdt_enable_ext(WDTO_1S);
 
+#ifdef GATE_SCHED_STATS
+	// first loop period starts here, not at cycle 0 (init time)
+	last_step = systick_cycles();
+#endif
+
 	if (supertask) {
 		for (;;) {
 			wdt_reset_ext();
-			supertask();
-
-			if (tasks) {
-				if (tasks->task) {
-					tasks->task();
-				}
-
-				if (!tasks->next) {
-					// error!
-					break;
-				}
-
-				tasks = tasks->next;
+			if (!gate_scheduler_step()) {
+				break;
 			}
 		}
 	}
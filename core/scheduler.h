@@ -34,6 +34,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "common.h"
+#include "hal/systick.h"
+#include "event.h"
 
 /**
  * @defgroup Sheduler Планировщик задач
@@ -42,6 +44,12 @@
  * 
  * Есть одна суперзадача, которая вызывается перед выполнением
  * любой другой задачи. Все остальные задачи выполняются по кольцу.
+ *
+ * Задача с ненулевым периодом (в тиках systick, см. SYSTICK_MS())
+ * вызывается не чаще одного раза за период, в остальных проходах
+ * кольца она пропускается. Задача с ненулевой маской событий
+ * вызывается по событию (см. event.h). Задача без периода и без событий
+ * вызывается на каждом проходе и не дает планировщику засыпать.
  */
 
 /**@{*/
@@ -54,11 +62,44 @@
  */
 typedef void (*GATE_TASK_FUNC)(void);
 
+#if defined(GATE_SCHED_STATS) || defined(__DOXYGEN__)
+/**
+ * Статистика процесса (только при GATE_SCHED_STATS).
+ * Время в тактах процессора, с точностью до делителя таймера systick.
+ */
+typedef struct {
+	uint16_t calls;      /**< Количество вызовов */
+	uint32_t cycles;     /**< Суммарное время выполнения */
+	uint32_t cycles_max; /**< Максимальное время одного вызова */
+} GATE_TASK_STATS;
+
+/** Количество интервалов гистограммы периода цикла */
+#define GATE_STATS_HIST_LEN 8
+
+/**
+ * Статистика планировщика.
+ * Интервал i гистограммы: период прохода меньше 256 << i тактов
+ * (последний — все, что больше).
+ */
+typedef struct {
+	uint32_t idle_cycles;  /**< Время в режиме сна */
+	uint32_t total_cycles; /**< Общее время работы цикла */
+	uint16_t loop_hist[GATE_STATS_HIST_LEN]; /**< Гистограмма периода прохода */
+	GATE_TASK_STATS super; /**< Статистика суперзадачи */
+} GATE_SCHEDULER_STATS;
+#endif
+
 /**
  * Конфигурация процесса.
  */
 typedef struct GATE_TASK_ {
 	GATE_TASK_FUNC task; /**< Функция процесса */
+	systick_t period;    /**< Период вызова в тиках (0 — на каждом проходе) */
+	systick_t next_run;  /**< Тик следующего вызова */
+	uint8_t events;      /**< Маска событий GATE_EVT_* */
+#ifdef GATE_SCHED_STATS
+	GATE_TASK_STATS stats; /**< Статистика процесса */
+#endif
 	struct GATE_TASK_* next; /**< Указатель на следующий процесс */
 } GATE_TASK;
 
@@ -76,9 +117,45 @@ GATE_RESULT gate_task_register(GATE_TASK* task);
  */
 GATE_RESULT gate_supertask_register(GATE_TASK_FUNC task);
 
+/**
+ * Задает маску событий суперзадачи.
+ * По умолчанию (0) суперзадача вызывается перед каждой задачей.
+ * Суперзадача с маской вызывается, только пока выставлено одно из ее
+ * событий; если работа не закончена, она должна выставить событие снова.
+ * @param events маска событий GATE_EVT_*
+ */
+void gate_supertask_set_events(uint8_t events);
+
+/**
+ * Один проход планировщика: суперзадача и текущая задача кольца,
+ * если подошло время ее вызова.
+ * @return false, если кольцо задач повреждено.
+ */
+bool gate_scheduler_step(void);
+
 /**
  * Главный цикл задач.
  */
 void gate_scheduler_loop(void);
 
+#if defined(GATE_SCHED_STATS) || defined(__DOXYGEN__)
+/** Статистика планировщика.
+ * @note Обновляется из основного цикла; при чтении из прерывания
+ *       значения могут быть несогласованы.
+ */
+extern GATE_SCHEDULER_STATS gate_sched_stats;
+
+/**
+ * Возвращает процесс по номеру в порядке обхода кольца.
+ * @param n номер процесса, начиная с 0
+ * @return NULL, если процесса с таким номером нет
+ */
+GATE_TASK* gate_task_nth(uint8_t n);
+
+/**
+ * Сбрасывает статистику планировщика и всех процессов.
+ */
+void gate_sched_stats_reset(void);
+#endif
+
 #endif
@@ -0,0 +1,95 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Coherent snapshots of ISR-updated data
+ * @file snapshot.h
+ */
+
+#ifndef GATE_SNAPSHOT_H
+#define GATE_SNAPSHOT_H
+
+#include <stdint.h>
+
+/**
+ * @defgroup Snapshot Согласованные снимки данных
+ *
+ * Данные, которые обновляются в прерываниях (результаты АЦП, положения
+ * сервоприводов), хранятся в двух кадрах. Писатель заполняет задний кадр
+ * и публикует его вызовом gate_snapshot_publish(); опубликованный
+ * (передний) кадр писатель не изменяет до следующей публикации.
+ *
+ * Номер кадра seq увеличивается при каждой публикации, его младший бит —
+ * индекс переднего кадра. Читатель копирует передний кадр и повторяет
+ * копирование, если за это время seq изменился, поэтому прерывания на
+ * время чтения не запрещаются. Обработчики прерываний (например, TWI)
+ * не прерываются писателем и могут читать передний кадр напрямую.
+ *
+ * @{
+ */
+
+/** Двойной буфер кадров
+ */
+typedef struct GATE_SNAPSHOT_ {
+	volatile uint8_t seq; /**< Номер опубликованного кадра */
+	uint8_t size;         /**< Размер кадра в байтах */
+	uint8_t* frames;      /**< Два кадра подряд */
+} GATE_SNAPSHOT;
+
+/** Инициализатор для массива из двух кадров
+ * @param buf массив вида type buf[2]
+ */
+#define GATE_SNAPSHOT_INIT(buf) \
+	{ .seq = 0, .size = sizeof((buf)[0]), .frames = (uint8_t*) (buf) }
+
+/** Опубликованный кадр
+ */
+static inline const void* gate_snapshot_front(const GATE_SNAPSHOT* s)
+{
+	return s->frames + ((s->seq & 1) ? s->size : 0);
+}
+
+/** Заполняемый кадр (только для писателя)
+ */
+static inline void* gate_snapshot_back(GATE_SNAPSHOT* s)
+{
+	return s->frames + ((s->seq & 1) ? 0 : s->size);
+}
+
+/** Публикация заднего кадра (только для писателя)
+ */
+static inline void gate_snapshot_publish(GATE_SNAPSHOT* s)
+{
+	__asm__ __volatile__ ("" ::: "memory");
+	s->seq++;
+}
+
+/** Копирование опубликованного кадра
+ * @param[in]  s снимок
+ * @param[out] frame буфер размером не меньше s->size
+ * @return номер скопированного кадра
+ */
+uint8_t gate_snapshot_read(const GATE_SNAPSHOT* s, void* frame);
+
+/**@}*/
+
+#endif // GATE_SNAPSHOT_H
@@ -0,0 +1,153 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Host test for scheduler core
+ * @file core/test.c
+ *
+ * Build and run: make -C core test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "scheduler.h"
+#include "snapshot.h"
+
+static unsigned super_calls;
+static unsigned fast_calls;
+static unsigned slow_calls;
+static unsigned poll_calls;
+
+static void super_func(void) { super_calls++; }
+static void fast_func(void) { fast_calls++; }
+static void slow_func(void) { slow_calls++; }
+static void poll_func(void) { poll_calls++; }
+
+static unsigned evt_calls;
+static void evt_func(void) { evt_calls++; }
+static GATE_TASK evt_task = { .task = evt_func, .events = GATE_EVT_ADC };
+
+static GATE_TASK fast_task = { .task = fast_func, .period = SYSTICK_MS(2) };
+static GATE_TASK slow_task = { .task = slow_func, .period = SYSTICK_MS(10) };
+static GATE_TASK poll_task = { .task = poll_func };
+
+static uint16_t frames[2][4];
+static GATE_SNAPSHOT snap = GATE_SNAPSHOT_INIT(frames);
+
+static int failed;
+
+#define check(expr) \
+	do { \
+		if (!(expr)) { \
+			printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #expr); \
+			failed++; \
+		} \
+	} while (0)
+
+static void run(unsigned steps, uint16_t ticks_per_step)
+{
+	while (steps--) {
+		check(gate_scheduler_step());
+		systick_lld_advance(ticks_per_step);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	(void)argc;
+	(void)argv;
+
+	gate_supertask_register(super_func);
+	gate_task_register(&fast_task);
+	gate_task_register(&slow_task);
+	gate_task_register(&poll_task);
+
+	// 3 tasks in ring, 1 ms per step: 300 ms simulated
+	run(300, SYSTICK_MS(1));
+
+	check(super_calls == 300);
+	check(poll_calls == 100);
+	// task seen every 3 ms, period 2 ms: runs once per visit (overrun)
+	check(fast_calls == 100);
+	// period 10 ms, visits every 3 ms: 30 runs in 300 ms
+	check(slow_calls >= 29 && slow_calls <= 31);
+
+	// no time passes: periodic tasks stay quiet
+	fast_calls = slow_calls = poll_calls = 0;
+	run(30, 0);
+	check(fast_calls <= 1);
+	check(slow_calls <= 1);
+	check(poll_calls == 10);
+
+	// tick counter wrap-around (~70 s at 1 s per step)
+	run(70, SYSTICK_MS(1000));
+	slow_calls = 0;
+	run(300, SYSTICK_MS(1));
+	check(slow_calls >= 29 && slow_calls <= 31);
+
+	// event-driven task and supertask
+	gate_task_register(&evt_task);
+	run(40, 0);
+	check(evt_calls == 0);
+	gate_event_post(GATE_EVT_ADC);
+	run(8, 0);
+	check(evt_calls == 1);
+
+	gate_supertask_set_events(GATE_EVT_SERIAL);
+	super_calls = 0;
+	run(40, 0);
+	check(super_calls == 0);
+	gate_event_post(GATE_EVT_SERIAL);
+	run(8, 0);
+	check(super_calls == 1);
+
+#ifdef GATE_SCHED_STATS
+	check(gate_task_nth(0) == &fast_task);
+	check(gate_task_nth(4) == NULL);
+	check(evt_task.stats.calls == 1);
+	check(gate_sched_stats.super.calls > 0);
+	gate_sched_stats_reset();
+	check(gate_sched_stats.super.calls == 0);
+	check(poll_task.stats.calls == 0);
+	run(30, 1);
+	check(poll_task.stats.calls == 7 || poll_task.stats.calls == 8);
+	check(gate_sched_stats.total_cycles == 29 * SYSTICK_LLD_CYCLES);
+#endif
+
+	// snapshot: writer never touches the published frame
+	uint16_t* back = gate_snapshot_back(&snap);
+	uint16_t frame[4];
+	back[0] = 1; back[3] = 4;
+	gate_snapshot_publish(&snap);
+	back = gate_snapshot_back(&snap);
+	check(back != gate_snapshot_front(&snap));
+	back[0] = 10;
+	check(gate_snapshot_read(&snap, frame) == 1);
+	check(frame[0] == 1 && frame[3] == 4);
+	gate_snapshot_publish(&snap);
+	check(gate_snapshot_read(&snap, frame) == 2);
+	check(frame[0] == 10);
+
+	printf("%s\n", failed ? "FAILED" : "OK");
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -6,6 +6,8 @@
 
 #include "wdt_ext.h"
 
+#if !defined(DEBUG) || DEBUG != 2
+
 /**
  *	WatchDog mode:
  *		0 - WDT not used yet;
@@ -101,3 +103,4 @@ void wdt_disable_extc(void)
 	}
 }
 
+#endif // DEBUG != 2
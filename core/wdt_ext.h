@@ -8,6 +8,25 @@
 #define WDT_EXT_H
 
 #include <stdint.h>
+
+#if defined(DEBUG) && DEBUG == 2
+// host build: no watchdog
+#define WDTO_15MS   0
+#define WDTO_30MS   1
+#define WDTO_60MS   2
+#define WDTO_120MS  3
+#define WDTO_250MS  4
+#define WDTO_500MS  5
+#define WDTO_1S     6
+#define WDTO_2S     7
+
+#define wdt_enable_ext(code)   ((void)(code))
+#define wdt_disable_ext()
+#define wdt_reset_ext()
+#define wdt_enable_extc(code)  ((void)(code))
+#define wdt_disable_extc()
+#define wdt_reset_extc()
+#else
 #include <avr/wdt.h>
 
 // ----- For main program ------------------------------------------
@@ -18,6 +37,7 @@ void wdt_reset_ext(void);
 // ----- For connection watchdog -----------------------------------
 void wdt_enable_extc(uint8_t);
 void wdt_disable_extc(void);
-#define wdt_reset_extc() __asm__ __volatile__ ("wdr")
+#define wdt_reset_extc() wdt_reset()
+#endif
 
 #endif
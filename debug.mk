@@ -16,3 +16,75 @@ $(gdbinit): $(target).elf
 	@echo "continue" >> $(gdbinit)
 	@echo
 	@echo "Use 'avr-gdb -x $(gdbinit)'"
+
+# PLATFORM=HOST_SIM: run the firmware as a host process
+sim: $(target).elf
+	chmod +x $(target).elf
+	./$(target).elf
+
+# PLATFORM=HOST_SIM: feed eterm/simtest/*.in, compare output
+# (telemetry frames decoded) with *.out; *.env holds extra environment
+SIM_TESTS = $(patsubst %.in,%,$(wildcard ${ORFA}/eterm/simtest/*.in))
+TLMDECODE = ${ORFA}/eterm/tlmdecode
+
+sim_test: $(target).elf
+	chmod +x $(target).elf
+	$(MAKE) -C ${ORFA}/eterm tlmdecode
+	for t in $(SIM_TESTS); do \
+		env ORFA_SIM_WDT=0 $$(cat $$t.env 2>/dev/null) \
+			./$(target).elf < $$t.in | $(TLMDECODE) | \
+			diff -u $$t.out - || exit 1; \
+	done
+
+# PLATFORM=HOST_SIM: eTerm parser fuzzing and throughput, see fuzz/fuzz.c
+# Fuzzer objects are built with other flags: firmware ones are cleaned
+# before and after. The fuzzer image is kept to replay fuzz/crash.txt.
+FUZZ_ELF = ${ORFA}/fuzz/orfa_fuzz.elf
+FUZZ_TIME = 60
+FUZZ_SEEDS = $(wildcard ${ORFA}/eterm/simtest/*.in)
+
+fuzz:
+	$(MAKE) clean
+	$(MAKE) FUZZ=yes $(FUZZ_ELF)
+	ORFA_SIM_WDT=0 $(FUZZ_ELF) -f $(FUZZ_TIME) $(FUZZ_SEEDS); \
+		r=$$?; $(MAKE) clean; rm -f ${ORFA}/fuzz/fuzz.o; exit $$r
+
+parser_bench:
+	$(MAKE) clean
+	$(MAKE) FUZZ=yes FUZZ_SAN=no $(FUZZ_ELF)
+	ORFA_SIM_WDT=0 $(FUZZ_ELF) -b; \
+		r=$$?; $(MAKE) clean; rm -f ${ORFA}/fuzz/fuzz.o; exit $$r
+
+# PLATFORM=HOST_SIM: the AVR TWI driver against a simulated bus, see
+# twitest/twitest.c. Firmware objects are cleaned before, the test
+# image ones after.
+TWITEST_ELF = ${ORFA}/twitest/orfa_twitest.elf
+
+twi_test:
+	$(MAKE) clean
+	$(MAKE) TWITEST=yes $(TWITEST_ELF)
+	ORFA_SIM_WDT=0 $(TWITEST_ELF) < /dev/null; \
+		r=$$?; $(MAKE) TWITEST=yes clean; exit $$r
+
+# cycle benchmarks on simulavr, see bench/bench.c
+BENCH_ELF = ${ORFA}/bench/orfa_bench.elf
+BENCH_RESULT = ${ORFA}/bench/$(PLATFORM).out
+BENCH_BASELINE = ${ORFA}/bench/baseline/$(PLATFORM).txt
+BENCH_TOLERANCE = 5
+
+bench_run:
+	$(MAKE) BENCH=yes $(BENCH_ELF)
+	simulavr --device $(MCU) -f $(BENCH_ELF) -W 0x20,- -e 0x21 \
+		-m 1000000000 > $(BENCH_RESULT)
+
+# fails on regressions against the checked-in baseline
+bench: bench_run
+	awk -v baseline=$(wildcard $(BENCH_BASELINE)) \
+		-v tolerance=$(BENCH_TOLERANCE) \
+		-f ${ORFA}/bench/compare.awk $(BENCH_RESULT)
+
+bench_baseline: bench_run
+	echo "# $(BOARD_NAME) $(MCU) cycles, make bench_baseline" > $(BENCH_BASELINE)
+	grep -E '^[a-z_0-9]+ [0-9]+$$' $(BENCH_RESULT) >> $(BENCH_BASELINE)
+
+.PHONY: sim sim_test fuzz parser_bench twi_test bench_run bench bench_baseline
@@ -8,9 +8,11 @@
 ##  - OR-AVR-M32-D
 ##  - OR-AVR-M128-S (default)
 ##  - OR-AVR-M128-DS
+##  - HOST-SIM (native process with OR-AVR-M32-D pinout, run by `make sim`)
 #PLATFORM = OR_AVR_M32_D
 #PLATFORM = OR_AVR_M128_S
 #PLATFORM = OR_AVR_M128_DS
+#PLATFORM = HOST_SIM
 
 ## Is it debug build? (default: nope)
 #DEBUG = 1
@@ -71,6 +73,10 @@
 #ADAPTERS += cannon
 #ADAPTERS += turret
 
+## I2C device polling: reads external device registers periodically
+## and caches them for one-burst reads (adapter 0x0070)
+#ADAPTERS += poll
+
 
 ## Defines
 ## =======
@@ -78,3 +84,27 @@
 ## Disable interrupt driven serial input
 #DEFINES += -DHAL_SERIAL_NISR
 
+## Disable interrupt driven serial output (wait for UART on every byte)
+#DEFINES += -DHAL_SERIAL_TX_NISR
+## Drop output on full transmit ring instead of waiting
+#DEFINES += -DHAL_SERIAL_TX_DROP
+
+## eTerm command macros in EEPROM ('M' command, see eterm/macroparser.c)
+#MACROS = yes
+
+## eTerm push telemetry ('R' command, see eterm/telemetry.h)
+#TELEMETRY = yes
+
+## eTerm binary mode ('B' command, see eterm/binmode.h)
+#BINMODE = yes
+
+## Scheduler statistics: per-task cycles, loop period histogram,
+## idle ratio (eTerm 'T' command and I2C adapter 0x0010).
+## Not for production builds.
+#SCHED_STATS = yes
+
+## I2C bus statistics: transfers, bytes, NACKs, arbitration losses,
+## bus errors, slave clock stretch and interrupt time
+## (eTerm 'I' command and I2C adapter 0x0011).
+#I2C_STATS = yes
+
@@ -0,0 +1,224 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Host benchmark for eTerm command dispatch and hex codec
+ * @file eterm/bench.c
+ *
+ * Build and run: make -C eterm bench
+ *
+ * Registers the full firmware command set (stub callbacks that end
+ * the command at '\n') and feeds short command lines to parse_command().
+ *
+ * Then compares lib/hex bulk hex_encode()/hex_decode() against the
+ * per-nibble itox()/xtoi() code sgparsers used before, on S read sized
+ * blocks of HEX_BLOCK bytes.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "eterm.h"
+#include "lib/hex.h"
+
+#define ITERATIONS 10000000UL
+
+#define HEX_BLOCK      16
+#define HEX_ITERATIONS 4000000UL
+
+static bool stub_parser(char c, bool reinit)
+{
+	return c == '\n';
+}
+
+// same commands as eterm_init() registers, in the same order
+static parser_t parsers[] = {
+	// sgparsers
+	PARSER_INIT('%', "comment", stub_parser),
+	PARSER_INIT('V', "protocol version", stub_parser),
+	PARSER_INIT('X', "clear i2c bus", stub_parser),
+	PARSER_INIT('L', "set/get local address", stub_parser),
+	PARSER_INIT('C', "set/get i2c speed", stub_parser),
+	PARSER_INIT('S', "i2c request", stub_parser),
+	// orc32parsers
+	PARSER_INIT('#', "SSC-32 servo move", stub_parser),
+	PARSER_INIT('Q', "SSC-32 query global status", stub_parser),
+	// portparsers
+	PARSER_INIT('P', "Pin control", stub_parser),
+	PARSER_INIT('A', "ADC config", stub_parser),
+	// wdtparser
+	PARSER_INIT('W', "WDT-command", stub_parser),
+	PARSER_INIT('N', "Reset connection watchdog", stub_parser),
+	// md2parsers
+	PARSER_INIT('D', "Drive chassis control", stub_parser),
+	// schedparser
+	PARSER_INIT('T', "scheduler statistics", stub_parser),
+};
+
+// first and last registered commands, lowercase aliases,
+// unknown command last
+static const char* commands[] = {
+	"%\n", "s\n", "#\n", "D\n", "t\n", "n\n", "Z\n",
+};
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// -- per-nibble reference, as in lib/hex.c before the tables --
+
+static __attribute__((noinline)) char ref_itox(uint8_t c)
+{
+	if (c <= 0x09)
+		return '0' + c;
+	else if (c <= 0x0f)
+		return 'A' + c - 10;
+	return 'X';
+}
+
+static __attribute__((noinline)) int8_t ref_xtoi(uint8_t c)
+{
+	if ((c >= '0')&&(c <= '9'))
+		return c - '0';
+	else if ((c >= 'A')&&(c <= 'F'))
+		return c - 'A' + 10;
+	return -1;
+}
+
+static void ref_encode(char *dst, const uint8_t *src, uint8_t len)
+{
+	while (len--) {
+		*dst++ = ref_itox(*src >> 4);
+		*dst++ = ref_itox(*src++ & 0x0f);
+	}
+}
+
+/// old get_xbyte(): one nibble per call
+static void ref_decode(uint8_t *dst, const char *src, uint8_t len)
+{
+	bool step = false;
+
+	for (uint8_t i=0; i < 2 * len; i++) {
+		int8_t xi = ref_xtoi(src[i]);
+		if (!step) {
+			*dst = xi << 4;
+			step = true;
+		} else {
+			*dst++ |= xi;
+			step = false;
+		}
+	}
+}
+
+static void report(const char *name, double t)
+{
+	printf("%-12s %7.1f MB/s\n", name,
+			HEX_ITERATIONS * HEX_BLOCK / t * 1e-6);
+}
+
+/** Time the codecs, check they agree
+ * @return false on mismatch
+ */
+static bool bench_hex(void)
+{
+	uint8_t raw[HEX_BLOCK], out[HEX_BLOCK];
+	char ref[2 * HEX_BLOCK], hex[2 * HEX_BLOCK];
+	unsigned long sum = 0;
+	double t;
+
+	for (int i=0; i < HEX_BLOCK; i++)
+		raw[i] = i * 37 + 11;
+
+	t = now();
+	for (unsigned long i=0; i < HEX_ITERATIONS; i++) {
+		raw[0] = i;
+		ref_encode(ref, raw, HEX_BLOCK);
+		sum += ref[1];
+	}
+	report("ref_encode", now() - t);
+
+	t = now();
+	for (unsigned long i=0; i < HEX_ITERATIONS; i++) {
+		raw[0] = i;
+		hex_encode(hex, raw, HEX_BLOCK);
+		sum -= hex[1];
+	}
+	report("hex_encode", now() - t);
+
+	t = now();
+	for (unsigned long i=0; i < HEX_ITERATIONS; i++) {
+		ref[i & 1] = ref_itox(i & 0x0f);
+		ref_decode(out, ref, HEX_BLOCK);
+		sum += out[0];
+	}
+	report("ref_decode", now() - t);
+
+	t = now();
+	for (unsigned long i=0; i < HEX_ITERATIONS; i++) {
+		ref[i & 1] = ref_itox(i & 0x0f);
+		sum -= hex_decode(out, ref, HEX_BLOCK) == HEX_BLOCK ? out[0] : 0x100;
+	}
+	report("hex_decode", now() - t);
+
+	ref_encode(ref, raw, HEX_BLOCK);
+	hex_encode(hex, raw, HEX_BLOCK);
+	return sum == 0 && !memcmp(ref, hex, sizeof(hex));
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long done = 0;
+	double t;
+
+	(void)argc;
+	(void)argv;
+
+	for (int i=0; i < ARRAY_SIZE(parsers); i++) {
+		register_parser(parsers + i);
+	}
+	register_help();
+
+	t = now();
+	for (unsigned long i=0; i < ITERATIONS; i++) {
+		const char* cmd = commands[i % ARRAY_SIZE(commands)];
+		if (parse_command(cmd[0], false) || parse_command(cmd[1], false))
+			done++;
+	}
+	t = now() - t;
+	printf("parse_command: %.1f M commands/s (%d parsers, %lu done)\n",
+			ITERATIONS / t * 1e-6, (int) ARRAY_SIZE(parsers) + 2, done);
+
+	if (done != ITERATIONS - ITERATIONS / ARRAY_SIZE(commands)) {
+		printf("unexpected number of commands\n");
+		return EXIT_FAILURE;
+	}
+
+	if (!bench_hex()) {
+		printf("hex codecs disagree\n");
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,245 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** eTerm binary mode
+ * @file binmode.c
+ */
+
+#include "eterm.h"
+#include "binmode.h"
+#include "hal/i2c.h"
+#include "hal/serial.h"
+#include "lib/crc16.h"
+#include "lib/fmt.h"
+
+#ifdef ETERM_BINMODE
+bool binmode_active;
+
+// -- receiver --
+
+static uint8_t frame[BIN_FRAME_LEN];
+static uint8_t frame_len;
+static bool frame_esc;
+static bool frame_overflow;
+
+// -- master --
+
+static i2c_xfer_t xfer;
+static uint8_t rx_buf[BIN_READ_LEN];
+#endif // ETERM_BINMODE
+
+// -- transmitter (also used by telemetry.c) --
+
+static uint16_t tx_crc;
+
+static void slip_put(uint8_t c) {
+	if (c == SLIP_END) {
+		serial_putbyte(SLIP_ESC);
+		c = SLIP_ESC_END;
+	} else if (c == SLIP_ESC) {
+		serial_putbyte(SLIP_ESC);
+		c = SLIP_ESC_ESC;
+	}
+	serial_putbyte(c);
+}
+
+void bin_frame_begin(void) {
+	tx_crc = CRC16_INIT;
+	serial_putbyte(SLIP_END);
+}
+
+void bin_frame_put(uint8_t c) {
+	tx_crc = crc16_update(tx_crc, c);
+	slip_put(c);
+}
+
+void bin_frame_end(void) {
+	uint16_t crc = tx_crc;
+	slip_put(crc & 0xff);
+	slip_put(crc >> 8);
+	serial_putbyte(SLIP_END);
+}
+
+#ifdef ETERM_BINMODE
+
+// -- ops --
+
+/** Master transfer, the frame waits for it
+ */
+static uint8_t do_xfer(uint8_t addr, const uint8_t *tx, uint8_t tx_len,
+		uint8_t rx_len) {
+	xfer.addr = addr;
+	xfer.tx = tx;
+	xfer.tx_len = tx_len;
+	xfer.rx = rx_buf;
+	xfer.rx_len = rx_len;
+	return i2c_transfer(&xfer);
+}
+
+/** Run ops of the checked frame
+ * @return false if EXIT was met
+ */
+static bool run_frame(void) {
+	uint8_t pos = 1;
+	uint8_t end = frame_len - 2;
+
+	while (pos < end) {
+		uint8_t op = frame[pos++];
+		uint8_t status;
+
+		if (op == BIN_OP_EXIT) {
+			bin_frame_put(I2C_E_OK);
+			return false;
+		}
+
+		if (op > BIN_OP_WRITE_READ || end - pos < 2) {
+			bin_frame_put(BIN_E_FORMAT);
+			break;
+		}
+
+		uint8_t addr = frame[pos++];
+		uint8_t len = frame[pos++];
+
+		if (op == BIN_OP_WRITE || op == BIN_OP_REG_WRITE) {
+			if (end - pos < len) {
+				bin_frame_put(BIN_E_FORMAT);
+				break;
+			}
+			if (op == BIN_OP_WRITE) {
+				status = do_xfer(addr, frame + pos, len, 0);
+			} else {
+				// register goes before data, in place of the length
+				frame[pos - 1] = addr;
+				status = do_xfer(i2c_get_local(), frame + pos - 1, len + 1, 0);
+			}
+			pos += len;
+			bin_frame_put(status);
+			continue;
+		}
+
+		// read length follows data written before the read
+		uint8_t wlen = 0;
+		if (op == BIN_OP_WRITE_READ) {
+			if (end - pos < len + 1) {
+				bin_frame_put(BIN_E_FORMAT);
+				break;
+			}
+			wlen = len;
+			len = frame[pos + wlen];
+		}
+
+		if (len == 0 || len > BIN_READ_LEN) {
+			bin_frame_put(BIN_E_LENGTH);
+			break;
+		}
+
+		if (op == BIN_OP_REG_READ)
+			status = do_xfer(i2c_get_local(), &addr, 1, len);
+		else
+			status = do_xfer(addr, frame + pos, wlen, len);
+		if (op == BIN_OP_WRITE_READ)
+			pos += wlen + 1;
+
+		bin_frame_put(status);
+		if (status == I2C_E_OK) {
+			for (uint8_t i = 0; i < len; i++)
+				bin_frame_put(rx_buf[i]);
+		}
+	}
+
+	return true;
+}
+
+static void process_frame(void) {
+	bool active = true;
+	uint16_t crc = CRC16_INIT;
+
+	bin_frame_begin();
+	bin_frame_put(frame[0]);
+
+	if (frame_overflow) {
+		bin_frame_put(BIN_E_LENGTH);
+	} else {
+		for (uint8_t i = 0; i < frame_len; i++)
+			crc = crc16_update(crc, frame[i]);
+
+		if (frame_len < 3 || crc != 0)
+			bin_frame_put(BIN_E_CRC);
+		else
+			active = run_frame();
+	}
+
+	bin_frame_end();
+	binmode_active = active;
+}
+
+void binmode_parse(uint8_t c) {
+	if (c == SLIP_END) {
+		if (frame_len)
+			process_frame();
+		frame_len = 0;
+		frame_esc = false;
+		frame_overflow = false;
+		return;
+	}
+
+	if (c == SLIP_ESC) {
+		frame_esc = true;
+		return;
+	}
+
+	if (frame_esc) {
+		frame_esc = false;
+		if (c == SLIP_ESC_END)
+			c = SLIP_END;
+		else if (c == SLIP_ESC_ESC)
+			c = SLIP_ESC;
+	}
+
+	if (frame_len < BIN_FRAME_LEN)
+		frame[frame_len++] = c;
+	else
+		frame_overflow = true;
+}
+
+// -- parser --
+
+static bool binmode_parser(char c, bool reinit) {
+	if (c == '\n') {
+		fmt_str_P(PSTR("B\n"));
+		frame_len = 0;
+		frame_esc = false;
+		frame_overflow = false;
+		binmode_active = true;
+		return true;
+	}
+	return false;
+}
+
+static parser_t binmode_parser_s = PARSER_INIT('B', "binary mode", binmode_parser);
+
+void register_binmode(void) {
+	register_parser(&binmode_parser_s);
+}
+
+#endif // ETERM_BINMODE
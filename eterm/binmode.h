@@ -0,0 +1,122 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** eTerm binary mode
+ * @file binmode.h
+ *
+ * Framed binary alternative to the ASCII serial gate protocol.
+ * Entered from ASCII mode with "B\n" (answer "B"), left with the EXIT op.
+ * Built with BINMODE = yes (ETERM_BINMODE); the frame output functions
+ * are always there for telemetry.h.
+ *
+ * Frames are SLIP encoded (RFC 1055): END 0xC0 delimits, inside a frame
+ * 0xC0 is sent as 0xDB 0xDC and 0xDB as 0xDB 0xDD.
+ *
+ * Request:  [seq] [op ...] [crc16 lo] [crc16 hi]
+ * Response: [seq] [result ...] [crc16 lo] [crc16 hi]
+ *
+ * CRC is lib/crc16.h over everything before it, so CRC over the whole
+ * payload including the CRC bytes gives 0.
+ *
+ * Ops are run in order, each one adds a result (status byte, then data
+ * for successful reads):
+ *   - 0x00 EXIT                          -- back to ASCII mode after reply
+ *   - 0x01 WRITE     addr len data[len]  -- i2c master write (7-bit addr)
+ *   - 0x02 READ      addr len            -- i2c master read, len > 0
+ *   - 0x03 REG_WRITE reg len data[len]   -- local register write
+ *   - 0x04 REG_READ  reg len             -- local register read, len > 0
+ *   - 0x05 WRITE_READ addr wlen data[wlen] len -- i2c master write, then
+ *                                           read after repeated START
+ *
+ * Status is one of I2C_E_* or BIN_E_*. On BIN_E_* the rest of the frame
+ * is skipped; bad CRC and overlong frames answer [seq] [status] only.
+ *
+ * Reading one 2-byte register at 115200 baud (11520 byte/s, half duplex
+ * request/response):
+ *   - ASCII  "S 00 05 S 01 02\n" -> "SWASR03FFP\r\n": 28 bytes, ~410 tps
+ *   - binary, one op per frame: 8 + 8 bytes, ~720 tps
+ *   - binary, 8 ops per frame: 29 + 29 bytes, ~1590 tps
+ */
+
+#ifndef ETERM_BINMODE_H
+#define ETERM_BINMODE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SLIP_END          0xC0
+#define SLIP_ESC          0xDB
+#define SLIP_ESC_END      0xDC
+#define SLIP_ESC_ESC      0xDD
+
+#define BIN_OP_EXIT       0x00
+#define BIN_OP_WRITE      0x01
+#define BIN_OP_READ       0x02
+#define BIN_OP_REG_WRITE  0x03
+#define BIN_OP_REG_READ   0x04
+#define BIN_OP_WRITE_READ 0x05
+
+#define BIN_E_FORMAT      0x80
+#define BIN_E_CRC         0x81
+#define BIN_E_LENGTH      0x82
+
+/// Max decoded request length
+#ifndef BIN_FRAME_LEN
+#define BIN_FRAME_LEN     72
+#endif
+
+/// Max length of one read op
+#ifndef BIN_READ_LEN
+#define BIN_READ_LEN      64
+#endif
+
+#if defined(ETERM_BINMODE) || defined(__DOXYGEN__)
+/// Binary mode is on
+extern bool binmode_active;
+
+/** Feed one received byte in binary mode
+ */
+void binmode_parse(uint8_t c);
+
+/** register 'B' command
+ */
+void register_binmode(void);
+#else
+#define binmode_active false
+#define binmode_parse(c) ((void)(c))
+#endif
+
+/** Start outgoing frame
+ * Also used for frames sent without a request (telemetry.h).
+ */
+void bin_frame_begin(void);
+
+/** Put byte of outgoing frame
+ */
+void bin_frame_put(uint8_t c);
+
+/** Put CRC and end outgoing frame
+ */
+void bin_frame_end(void);
+
+#endif // ETERM_BINMODE_H
@@ -28,45 +28,122 @@
  */
 
 #include "eterm.h"
+#include "lib/fmt.h"
 
-parser_t *rootparser;
+static parser_t *currparser;
+
+/// Tag digits after '@'
+#define TAG_DIGITS 2
+/// in_tag: bad tag, the rest of the line is dropped
+#define TAG_SKIP   0xff
+
+/// "@tt " prefix: 0 -- none, 1.. -- tag digits read plus one, TAG_SKIP
+static uint8_t in_tag;
+static int16_t cmd_tag = ETERM_NO_TAG;
+int16_t eterm_out_tag = ETERM_NO_TAG;
+
+/// Registered parsers, in registration order
+static parser_t *parsers[ETERM_MAX_PARSERS];
+static uint8_t parsers_count;
+
+/// Dispatch table covers commands ' '..'_'
+#define DISPATCH_FIRST ' '
+#define DISPATCH_LEN   64
+
+/** Command -> parser table
+ * Holds index in parsers[] plus one, 0 -- no parser.
+ * Bytes instead of pointers: 64 B of SRAM, not 128 B.
+ */
+static uint8_t dispatch[DISPATCH_LEN];
+
+/** Dispatch table slot of command
+ * Lowercase letters map to uppercase, like toupper().
+ * @return DISPATCH_LEN if command can't have a parser
+ */
+static inline uint8_t dispatch_index(char command) {
+	uint8_t c = command;
+	if (c >= 'a' && c <= 'z') {
+		c -= 'a' - 'A';
+	}
+	c -= DISPATCH_FIRST;
+	return (c < DISPATCH_LEN) ? c : DISPATCH_LEN;
+}
 
 static parser_t *find_parser(char command) {
-	parser_t *it=rootparser;
-	command = toupper(command);
-	while (it) {
-		if (it->command == command) {
-			return it;
-		}
-		it = it->next;
+	uint8_t i = dispatch_index(command);
+	if (i >= DISPATCH_LEN || !dispatch[i]) {
+		return NULL;
 	}
-	return NULL;
+	return parsers[dispatch[i] - 1];
 }
 
 void register_parser(parser_t *parser) {
-	parser_t *alredy_added = find_parser(parser->command);
-	if (alredy_added) {
+	uint8_t i = dispatch_index(parser->command);
+	if (i >= DISPATCH_LEN || dispatch[i] ||
+			parsers_count >= ETERM_MAX_PARSERS) {
 		//perror("parser alredy added");
 		return;
 	}
-	parser->next = rootparser;
-	rootparser = parser;
+	parsers[parsers_count++] = parser;
+	dispatch[i] = parsers_count;
+}
+
+int16_t eterm_tag(void) {
+	return cmd_tag;
+}
+
+bool parse_idle(void) {
+	return !currparser && !in_tag;
 }
 
 bool parse_command(char c, bool reinit) {
-	static parser_t *currparser;
 	bool res;
 
 	if (reinit) {
 		currparser = NULL;
+		in_tag = 0;
+		cmd_tag = eterm_out_tag = ETERM_NO_TAG;
 	}
 
 	if (c == '\r') {
 		c = '\n';
 	}
 
+	if (!currparser) {
+		// "@tt " prefix: tag of the command, two hex digits and a space
+		if (in_tag == TAG_SKIP) {
+			if (c == '\n') {
+				in_tag = 0;
+			}
+			return false;
+		}
+		if (!in_tag && c == '@') {
+			in_tag = 1;
+			cmd_tag = 0;
+			return false;
+		}
+		if (in_tag) {
+			if (in_tag <= TAG_DIGITS && isxdigit((unsigned char) c)) {
+				cmd_tag = (cmd_tag << 4) |
+					(c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+				in_tag++;
+				return false;
+			}
+			if (in_tag == TAG_DIGITS + 1 && c == ' ') {
+				in_tag = 0;
+				return false;
+			}
+			// the command letter may be taken for a digit: don't run it
+			fmt_str_P(PSTR("@ Error. Invalid tag\n"));
+			cmd_tag = ETERM_NO_TAG;
+			in_tag = (c == '\n') ? 0 : TAG_SKIP;
+			return false;
+		}
+	}
+
 	// special case: blank line
 	if (!currparser && c == '\n') {
+		cmd_tag = ETERM_NO_TAG;
 		return false;
 	}
 
@@ -76,6 +153,7 @@ bool parse_command(char c, bool reinit) {
 			//perror("unknown command");
 			return false;
 		}
+		eterm_out_tag = cmd_tag;
 		res = currparser->callback(c, true);
 	} else {
 		res = currparser->callback(c, false);
@@ -84,6 +162,7 @@ bool parse_command(char c, bool reinit) {
 	// parsing done, clear current parser
 	if (res) {
 		currparser = NULL;
+		cmd_tag = eterm_out_tag = ETERM_NO_TAG;
 	}
 
 	return res;
@@ -92,11 +171,14 @@ bool parse_command(char c, bool reinit) {
 // -- help code --
 
 static inline void print_help(void) {
-	parser_t *it=rootparser;
-	puts("Commands:");
-	while (it) {
-		printf("  '%c'\t\t%s\n", it->command, it->help);
-		it = it->next;
+	fmt_str_P(PSTR("Commands:\n"));
+	for (uint8_t i=0; i < parsers_count; i++) {
+		parser_t *it = parsers[i];
+		fmt_str_P(PSTR("  '"));
+		putchar(it->command);
+		fmt_str_P(PSTR("'\t\t"));
+		fmt_str(it->help);
+		putchar('\n');
 	}
 }
 
@@ -53,21 +53,57 @@ struct parser_s {
 	char command;
 	char *help;
 	parser_callback callback;
-	struct parser_s *next;
 };
 
+/// Max number of registered parsers
+#ifndef ETERM_MAX_PARSERS
+#define ETERM_MAX_PARSERS 24
+#endif
+
 /** Parser registration function
+ * Command chars are ' '..'_', letters are case insensitive.
+ * Parser for an already registered command is ignored, as is any
+ * parser past ETERM_MAX_PARSERS.
  * @param *parser  filled parser 
  */
 void register_parser(parser_t *parser);
 
 /** Parse the command
+ * A command may be prefixed with "@tt " (tt -- hex tag), then every
+ * line of its response starts with "@tt ". The tag is two hex digits
+ * and a space; otherwise the line is dropped with "@ Error. Invalid tag".
  */
 bool parse_command(char c, bool reinit);
 
+/// Command has no tag
+#define ETERM_NO_TAG  (-1)
+
+/** Tag of the command being parsed
+ * @return tag or ETERM_NO_TAG
+ */
+int16_t eterm_tag(void);
+
+/** Tag put before each output line (ETERM_NO_TAG -- none)
+ * Set by parse_command for the current command.
+ */
+extern int16_t eterm_out_tag;
+
+/** Parser is between commands
+ */
+bool parse_idle(void);
+
 /** register '?' and 'h' commands
  */
 void register_help(void);
 
+/// Returned by port_letter_number() for a port the board doesn't have
+#define ILLIGAL_PORT  100
+
+/** Port number of port letter (portparsers.c)
+ * @param _port  port letter, upper case
+ * @return port number, ILLIGAL_PORT if board has no such port
+ */
+uint8_t port_letter_number(uint8_t _port);
+
 #endif // !ETERM_H
 
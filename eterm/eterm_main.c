@@ -28,43 +28,123 @@
 
 #include "eterm.h"
 #include "eterm_main.h"
+#include "binmode.h"
+#include "telemetry.h"
 #include "hal/i2c.h"
 #include "hal/serial.h"
+#include "lib/hex.h"
 
 
 void register_serialgate(void);
+bool serialgate_queue_run(void);
+bool serialgate_hold(void);
 void register_orc32(void);
 void register_port(void);
 void register_wdt(void);
 #ifdef HAVE_MOTOR
 void register_md2(void);
 #endif
+#ifdef GATE_SCHED_STATS
+void register_sched(void);
+#endif
+#ifdef HAL_I2C_STATS
+void register_i2cstats(void);
+#endif
+#ifdef ETERM_MACROS
+void register_macro(void);
+bool macro_run(void);
+#else
+#define macro_run() false
+#endif
+
+/** Put tag of the command before each response line
+ */
+static void tag_line_handler(void) {
+	if (eterm_out_tag != ETERM_NO_TAG) {
+		serial_putbyte('@');
+		serial_putbyte(itox(eterm_out_tag >> 4));
+		serial_putbyte(itox(eterm_out_tag & 0xf));
+		serial_putbyte(' ');
+	}
+}
 
 void eterm_init(void) {
 	register_serialgate();
 	register_orc32();
 	register_port();
 	register_wdt();
+#ifdef ETERM_BINMODE
+	register_binmode();
+#endif
 	register_help();
 
 #ifdef HAVE_MOTOR
 	register_md2();
 #endif
 
+#ifdef GATE_SCHED_STATS
+	register_sched();
+#endif
+
+#ifdef HAL_I2C_STATS
+	register_i2cstats();
+#endif
+
+#ifdef ETERM_MACROS
+	register_macro();
+#endif
+
+#ifdef ETERM_TELEMETRY
+	register_telemetry();
+#endif
+
 #ifdef HAL_HAVE_SERIAL_FILE_DEVICE
 	serial_init(BAUD);
 	stdin = stdout = stderr = &serial_fdev;
+	serial_set_line_handler(tag_line_handler);
 #endif
 
 	i2c_init();
 }
 
 void eterm_supertask(void) {
-	if(serial_isempty())
-		return;
+	static uint8_t buf[ETERM_RX_BATCH];
+	static uint8_t pos, len;
+	bool more = false;
+	bool line = false;
+
+	// queued requests run between commands, done ones answer first
+	if (!binmode_active && parse_idle())
+		more = serialgate_queue_run();
+
+	// commands after an untagged request wait for its answer
+	if (!serialgate_hold()) {
+		// macro lines go before the input that follows their command
+		line = !binmode_active && parse_idle() && macro_run();
+
+		if (!line) {
+			if (pos == len) {
+				len = serial_read(buf, sizeof(buf));
+				pos = 0;
+			}
+
+			while (pos < len && !line && !serialgate_hold()) {
+				uint8_t c = buf[pos++];
+				if (binmode_active)
+					binmode_parse(c);
+				else if (parse_command(c, false))
+					line = macro_run();
+			}
+		}
 
-	uint8_t c = getchar();
+		// start request just parsed
+		if (!binmode_active && parse_idle())
+			more |= serialgate_queue_run();
+	}
 
-	parse_command(c, false);
+	// held input waits for GATE_EVT_I2C_MASTER
+	if (more || line ||
+		(!serialgate_hold() && (pos < len || !serial_isempty())))
+		gate_event_post(GATE_EVT_SERIAL);
 }
 
@@ -30,6 +30,23 @@
 #ifndef ETERM_M_H
 #define ETERM_M_H
 
+#include "core/event.h"
+
+/** Events that wake eterm_supertask (0 -- polled)
+ */
+#ifndef HAL_SERIAL_NISR
+#define ETERM_SUPERTASK_EVENTS  (GATE_EVT_SERIAL | GATE_EVT_I2C_MASTER)
+#else
+#define ETERM_SUPERTASK_EVENTS  0
+#endif
+
+/** Max received bytes handled per supertask pass
+ * Larger batch -- less latency for long lines, longer pass.
+ */
+#ifndef ETERM_RX_BATCH
+#define ETERM_RX_BATCH  16
+#endif
+
 void eterm_init(void);
 void eterm_supertask(void);
 
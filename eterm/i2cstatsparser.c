@@ -0,0 +1,113 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** I2C bus statistics parser
+ *
+ * Parsers list:
+ *   - I  -- print I2C bus statistics
+ *   - IR -- reset I2C bus statistics
+ *
+ * Output:
+ * @code
+ * I master=<transfers>,<bytes> slave=<transactions>,<bytes>
+ * IE nack=<addr>,<data> arb=<n> bus=<n> timeout=<n>
+ * IT stretch=<cycles> isr=<max cycles>
+ * @endcode
+ *
+ * @file i2cstatsparser.c
+ */
+
+#include "eterm.h"
+#include "hal/i2c.h"
+#include "lib/fmt.h"
+
+static void print_pair(PGM_P name, uint32_t a, uint32_t b)
+{
+	fmt_str_P(name);
+	fmt_u32(a);
+	putchar(',');
+	fmt_u32(b);
+}
+
+static void print_stats(void)
+{
+	i2c_stats_t st;
+
+	i2c_stats_read(&st);
+
+	putchar('I');
+	print_pair(PSTR(" master="), st.m_xfers, st.m_bytes);
+	print_pair(PSTR(" slave="), st.s_xfers, st.s_bytes);
+	putchar('\n');
+
+	fmt_str_P(PSTR("IE"));
+	print_pair(PSTR(" nack="), st.addr_nack, st.data_nack);
+	fmt_str_P(PSTR(" arb="));
+	fmt_u16(st.arb_lost);
+	fmt_str_P(PSTR(" bus="));
+	fmt_u16(st.bus_errors);
+	fmt_str_P(PSTR(" timeout="));
+	fmt_u16(st.timeouts);
+	putchar('\n');
+
+	fmt_str_P(PSTR("IT stretch="));
+	fmt_u32(st.stretch_cycles);
+	fmt_str_P(PSTR(" isr="));
+	fmt_u16(st.isr_max);
+	putchar('\n');
+}
+
+static bool i2cstats_parser(char c, bool reinit) {
+	static bool reset;
+
+	if (reinit) {
+		reset = false;
+		return false;
+	}
+
+	if (toupper(c) == 'R')
+		reset = true;
+
+	if (c == '\n') {
+		if (reset) {
+			i2c_stats_reset();
+			fmt_str_P(PSTR("IR\n"));
+		} else {
+			print_stats();
+		}
+		return true;
+	}
+	return false;
+}
+
+// -- table --
+
+static parser_t i2cstatsparsers[] = {
+	PARSER_INIT('I', "i2c statistics", i2cstats_parser),
+};
+
+void register_i2cstats(void) {
+	for (uint8_t i=0; i < ARRAY_SIZE(i2cstatsparsers); i++) {
+		register_parser(i2cstatsparsers + i);
+	}
+}
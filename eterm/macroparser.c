@@ -0,0 +1,804 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** eTerm command macros
+ *
+ * A macro is a named sequence of eTerm lines kept in EEPROM. Replay
+ * feeds its lines to parse_command(), one line per supertask pass,
+ * so its responses come out as if the host had sent the lines. Serial
+ * input after the command that started a replay waits for its end.
+ *
+ * Commands (names: up to MACRO_NAME_LEN of A-Z, 0-9, '_'):
+ *   - MWname:line;line... -- store macro (replaces old one),
+ *                            answer after EEPROM write: "MWname"
+ *   - MXname              -- replay now: "MXname"
+ *   - MDname              -- delete: "MDname"
+ *   - ML                  -- list: "M=name,bytes" per macro, "MLfree"
+ *   - MTname,ms           -- replay every ms (0 -- stop): "MTname,ms"
+ *   - MEname,Pn,e         -- replay on edge e (R, F or B -- both)
+ *                            of pin n of port P: "MEname,Pn,e"
+ *   - MEname              -- remove edge triggers of macro: "MEname"
+ *   - MC                  -- clear all triggers, stop replay: "MC"
+ *
+ * Macro lines can't be 'M' or 'B' commands. Triggers live in RAM only.
+ * Port edges are polled every MACRO_POLL_MS; a replay that is already
+ * waiting to start is not queued again.
+ *
+ * EEPROM record: [size][name length][name][lines, each ends with '\n'],
+ * size 0xff (erased) ends the records. MD only zeroes the name length
+ * (tombstone). Deleted records are reclaimed by MW, when the space
+ * after the last record runs out: a compaction step can write a couple
+ * of hundred EEPROM bytes, too long for the macro task.
+ *
+ * A reset at any point loses no macro but the one being written or
+ * deleted. Compaction moves a record through a journal after the
+ * records, which is replayed at start. MW writes the new record before
+ * deleting the old one; if a reset leaves both, rec_fixup() keeps the
+ * later one.
+ *
+ * @file macroparser.c
+ */
+
+#include "eterm.h"
+#include "lib/fmt.h"
+#include "core/ports.h"
+#include "core/scheduler.h"
+#include "core/wdt_ext.h"
+#include "hal/systick.h"
+#include <string.h>
+#include <avr/eeprom.h>
+
+/// First EEPROM byte for macros
+#ifndef MACRO_EE_START
+#define MACRO_EE_START  0
+#endif
+
+/// Longest macro name
+#ifndef MACRO_NAME_LEN
+#define MACRO_NAME_LEN  8
+#endif
+
+/// Longest macro text, line ends included
+#ifndef MACRO_TEXT_LEN
+#define MACRO_TEXT_LEN  96
+#endif
+
+/// Timer and port edge trigger slots
+#ifndef MACRO_TRIG_LEN
+#define MACRO_TRIG_LEN  4
+#endif
+
+/// Port edge polling period, ms
+#ifndef MACRO_POLL_MS
+#define MACRO_POLL_MS   1
+#endif
+
+#define MACRO_NONE      0xffff
+#define MACRO_HDR       2              ///< [size][name length]
+#define MACRO_END       0xff           ///< size of erased EEPROM
+#define MACRO_DEAD      0              ///< name length of deleted record
+#define MACRO_DEAD_MIN  (MACRO_HDR + 1) ///< smallest deleted record
+#define MACRO_SIZE_MAX  (MACRO_END - 1) ///< biggest (deleted) record
+#define MACRO_REC_MAX   (MACRO_HDR + MACRO_NAME_LEN + MACRO_TEXT_LEN)
+#define MACRO_RUN_NOW   MACRO_TRIG_LEN ///< pending bit of 'MX'
+#define MACRO_PERIOD_MAX ((uint16_t) (0x7fffUL * 1000 / SYSTICK_HZ))
+
+/** Compaction journal: [flag][dst lo][dst hi][hole size][record]
+ * flag MACRO_JOURNAL_SET -- record is to be copied to dst, then a
+ * deleted record of hole size put after it.
+ */
+#define MACRO_JOURNAL_HDR 4
+#define MACRO_JOURNAL_LEN (MACRO_JOURNAL_HDR + MACRO_REC_MAX)
+#define MACRO_JOURNAL_SET 0x00
+
+/// EEPROM end for macros (exclusive), the journal goes after it
+#ifndef MACRO_EE_END
+#define MACRO_EE_END    (E2END + 1 - MACRO_JOURNAL_LEN)
+#endif
+
+#define MACRO_JOURNAL   MACRO_EE_END
+
+#if MACRO_REC_MAX >= MACRO_END
+#error "macro record size doesn't fit in a byte"
+#endif
+
+#if MACRO_EE_END + MACRO_JOURNAL_LEN > E2END + 1 || \
+		MACRO_EE_START >= MACRO_EE_END
+#error "macro store and journal are out of EEPROM"
+#endif
+
+#if MACRO_TRIG_LEN > 7
+#error "too many macro triggers"
+#endif
+
+typedef struct {
+	uint16_t rec;     ///< macro record, MACRO_NONE -- free slot
+	char type;        ///< 'T' -- timer, 'R', 'F', 'B' -- port edge
+	uint8_t port;     ///< port number
+	uint8_t mask;     ///< pin mask
+	uint8_t last;     ///< last pin level (masked)
+	systick_t period; ///< timer period, ticks
+	systick_t next;   ///< next timer run
+} macro_trig_t;
+
+static macro_trig_t trig[MACRO_TRIG_LEN];
+static uint8_t pending;   ///< replays to start: bit per trigger, MACRO_RUN_NOW
+static uint16_t now_rec;  ///< record of 'MX'
+static uint16_t run_pos;  ///< next EEPROM byte of replay
+static uint8_t run_left;  ///< bytes left of replay, 0 -- none
+
+/// Command line: subcommand, name, ':' and text (NUL becomes last '\n')
+static char line[MACRO_NAME_LEN + MACRO_TEXT_LEN + 2];
+static uint8_t line_len;
+static bool line_over;
+
+// -- EEPROM records --
+
+#define EE_PTR(addr) ((uint8_t *) (uintptr_t) (addr))
+
+static inline uint8_t ee_byte(uint16_t addr) {
+	return eeprom_read_byte(EE_PTR(addr));
+}
+
+/** Size of record at rec
+ * @return 0 -- no record (end of records)
+ */
+static uint8_t rec_size(uint16_t rec) {
+	uint8_t size;
+
+	if (rec + MACRO_HDR > MACRO_EE_END)
+		return 0;
+
+	size = ee_byte(rec);
+	if (size == MACRO_END || size <= MACRO_HDR + ee_byte(rec + 1) ||
+			rec + size > MACRO_EE_END)
+		return 0;
+
+	return size;
+}
+
+static bool rec_is(uint16_t rec, const char *name, uint8_t nlen) {
+	if (ee_byte(rec + 1) != nlen)
+		return false;
+
+	for (uint8_t i=0; i < nlen; i++) {
+		if (ee_byte(rec + MACRO_HDR + i) != name[i])
+			return false;
+	}
+	return true;
+}
+
+/** Find macro record
+ * @param name macro name, NULL -- find end of records
+ * @return MACRO_NONE if not found
+ */
+static uint16_t rec_find(const char *name, uint8_t nlen) {
+	uint16_t rec = MACRO_EE_START;
+	uint8_t size;
+
+	while ((size = rec_size(rec))) {
+		if (name && rec_is(rec, name, nlen))
+			return rec;
+		rec += size;
+	}
+	return name ? MACRO_NONE : rec;
+}
+
+static inline bool rec_dead(uint16_t rec) {
+	return ee_byte(rec + 1) == MACRO_DEAD;
+}
+
+/** Copy EEPROM bytes, lowest address first
+ */
+static void ee_copy(uint16_t dst, uint16_t src, uint8_t len) {
+	while (len--)
+		eeprom_update_byte(EE_PTR(dst++), ee_byte(src++));
+}
+
+static inline void ee_put16(uint16_t addr, uint16_t val) {
+	eeprom_update_byte(EE_PTR(addr), val & 0xff);
+	eeprom_update_byte(EE_PTR(addr + 1), val >> 8);
+}
+
+/** Delete record: zero its name length
+ * Triggers and replay of the record stop.
+ */
+static void rec_kill(uint16_t rec) {
+	uint8_t size = rec_size(rec);
+
+	eeprom_update_byte(EE_PTR(rec + 1), MACRO_DEAD);
+
+	for (uint8_t i=0; i < MACRO_TRIG_LEN; i++) {
+		if (trig[i].rec == rec) {
+			trig[i].rec = MACRO_NONE;
+			pending &= ~(1 << i);
+		}
+	}
+
+	if (pending & (1 << MACRO_RUN_NOW) && now_rec == rec)
+		pending &= ~(1 << MACRO_RUN_NOW);
+
+	if (run_left && run_pos >= rec && run_pos < rec + size)
+		run_left = 0;
+}
+
+/** Finish the journaled move, if any
+ * Safe to run again after a reset cut it.
+ */
+static void journal_apply(void) {
+	uint16_t dst;
+	uint8_t size, hole;
+
+	if (ee_byte(MACRO_JOURNAL) != MACRO_JOURNAL_SET)
+		return;
+
+	dst = ee_byte(MACRO_JOURNAL + 1) | (ee_byte(MACRO_JOURNAL + 2) << 8);
+	hole = ee_byte(MACRO_JOURNAL + 3);
+	size = ee_byte(MACRO_JOURNAL + MACRO_JOURNAL_HDR);
+
+	if (dst >= MACRO_EE_START && size > MACRO_HDR && size <= MACRO_REC_MAX &&
+			hole >= MACRO_DEAD_MIN && dst + size + hole <= MACRO_EE_END) {
+		ee_copy(dst, MACRO_JOURNAL + MACRO_JOURNAL_HDR, size);
+		eeprom_update_byte(EE_PTR(dst + size + 1), MACRO_DEAD);
+		eeprom_update_byte(EE_PTR(dst + size), hole);
+	}
+	eeprom_update_byte(EE_PTR(MACRO_JOURNAL), MACRO_END);
+}
+
+/** Move record rec down over deleted record hole right before it
+ * The record is saved to the journal first, the flag is written last.
+ * Triggers and replay follow the record.
+ */
+static void rec_move(uint16_t hole, uint8_t hole_size, uint16_t rec, uint8_t size) {
+	ee_copy(MACRO_JOURNAL + MACRO_JOURNAL_HDR, rec, size);
+	ee_put16(MACRO_JOURNAL + 1, hole);
+	eeprom_update_byte(EE_PTR(MACRO_JOURNAL + 3), hole_size);
+	eeprom_update_byte(EE_PTR(MACRO_JOURNAL), MACRO_JOURNAL_SET);
+
+	for (uint8_t i=0; i < MACRO_TRIG_LEN; i++) {
+		if (trig[i].rec == rec)
+			trig[i].rec = hole;
+	}
+
+	if (now_rec == rec)
+		now_rec = hole;
+
+	if (run_left && run_pos >= rec && run_pos < rec + size)
+		run_pos -= hole_size;
+
+	journal_apply();
+}
+
+/** One compaction step
+ * Finds the first deleted record and drops it if it is the last one,
+ * merges it with a deleted neighbour, or moves the next record over it.
+ * @return false if nothing is left to do
+ */
+static bool rec_compact(void) {
+	uint16_t rec = MACRO_EE_START;
+	uint8_t size;
+
+	while ((size = rec_size(rec))) {
+		uint16_t next = rec + size;
+		uint8_t nsize;
+
+		if (!rec_dead(rec)) {
+			rec = next;
+			continue;
+		}
+
+		nsize = rec_size(next);
+		if (!nsize) {
+			eeprom_update_byte(EE_PTR(rec), MACRO_END);
+			return true;
+		}
+
+		if (!rec_dead(next)) {
+			rec_move(rec, size, next, nsize);
+			return true;
+		}
+
+		if (size + nsize <= MACRO_SIZE_MAX) {
+			eeprom_update_byte(EE_PTR(rec), size + nsize);
+			return true;
+		}
+
+		// too big to merge, the next one goes on
+		rec = next;
+	}
+	return false;
+}
+
+/** Recover after reset
+ * Finishes the journaled move and deletes the older copy of macros
+ * stored twice: a reset between writing the new copy and deleting the
+ * old one in MW leaves both.
+ */
+static void rec_fixup(void) {
+	uint16_t rec = MACRO_EE_START;
+	uint8_t size;
+
+	journal_apply();
+
+	while ((size = rec_size(rec))) {
+		uint8_t nlen = ee_byte(rec + 1);
+
+		if (nlen != MACRO_DEAD && nlen <= MACRO_NAME_LEN) {
+			char name[MACRO_NAME_LEN];
+			uint16_t it = rec + size;
+			uint8_t isize;
+
+			for (uint8_t i=0; i < nlen; i++)
+				name[i] = ee_byte(rec + MACRO_HDR + i);
+
+			while ((isize = rec_size(it))) {
+				if (rec_is(it, name, nlen)) {
+					eeprom_update_byte(EE_PTR(rec + 1), MACRO_DEAD);
+					break;
+				}
+				it += isize;
+			}
+		}
+		rec += size;
+	}
+}
+
+/** Free bytes: after the last record and in deleted records
+ */
+static uint16_t rec_free(void) {
+	uint16_t rec = MACRO_EE_START;
+	uint16_t dead = 0;
+	uint8_t size;
+
+	while ((size = rec_size(rec))) {
+		if (rec_dead(rec))
+			dead += size;
+		rec += size;
+	}
+	return MACRO_EE_END - rec + dead;
+}
+
+/** Store record at end of records, delete the old one after that
+ * Compacts the records if there is no space at the end. If it is still
+ * short, the old record goes first.
+ * @return false if no space (nothing is changed)
+ */
+static bool rec_write(const char *name, uint8_t nlen, const char *text, uint8_t tlen) {
+	uint16_t old = rec_find(name, nlen);
+	bool replace = old != MACRO_NONE;
+	uint16_t end = rec_find(NULL, 0);
+	uint8_t size = MACRO_HDR + nlen + tlen;
+
+	if (size > rec_free() + (replace ? rec_size(old) : 0))
+		return false;
+
+	while (end + size > MACRO_EE_END) {
+		// a step may copy a whole record twice, ~3.4 ms per EEPROM byte
+		wdt_reset_ext();
+		if (!rec_compact()) {
+			// compaction may have moved it
+			rec_kill(rec_find(name, nlen));
+			replace = false;
+		}
+		end = rec_find(NULL, 0);
+	}
+
+	if (end + size < MACRO_EE_END)
+		eeprom_update_byte(EE_PTR(end + size), MACRO_END);
+	eeprom_update_byte(EE_PTR(end + 1), nlen);
+	eeprom_update_block(name, EE_PTR(end + MACRO_HDR), nlen);
+	eeprom_update_block(text, EE_PTR(end + MACRO_HDR + nlen), tlen);
+	eeprom_update_byte(EE_PTR(end), size);
+
+	// first match is the old copy
+	if (replace)
+		rec_kill(rec_find(name, nlen));
+	return true;
+}
+
+// -- replay --
+
+/** Start next pending replay
+ * @return false if none
+ */
+static bool run_next(void) {
+	uint16_t rec;
+	uint8_t i, nlen;
+
+	for (i=0; i <= MACRO_RUN_NOW; i++) {
+		if (pending & (1 << i))
+			break;
+	}
+	if (i > MACRO_RUN_NOW)
+		return false;
+
+	pending &= ~(1 << i);
+	rec = (i == MACRO_RUN_NOW) ? now_rec : trig[i].rec;
+	nlen = ee_byte(rec + 1);
+	run_pos = rec + MACRO_HDR + nlen;
+	run_left = rec_size(rec) - MACRO_HDR - nlen;
+	return true;
+}
+
+/** Replay one macro line
+ * Call between commands only (parse_idle()).
+ * @return false if no replay is waiting
+ */
+bool macro_run(void) {
+	char c;
+
+	if (!run_left && !run_next())
+		return false;
+
+	do {
+		c = ee_byte(run_pos++);
+		run_left--;
+		parse_command(c, false);
+	} while (c != '\n' && run_left);
+
+	// don't leave a command half parsed for the serial input
+	if (!parse_idle())
+		parse_command('\n', true);
+
+	return true;
+}
+
+static void macro_task(void) {
+	systick_t now = systick_get();
+	uint8_t bits;
+
+	for (uint8_t i=0; i < MACRO_TRIG_LEN; i++) {
+		macro_trig_t *t = trig + i;
+
+		if (t->rec == MACRO_NONE)
+			continue;
+
+		if (t->type == 'T') {
+			if (!systick_after_eq(now, t->next))
+				continue;
+			t->next += t->period;
+			if (systick_after_eq(now, t->next))
+				t->next = now + t->period;
+		} else {
+			if (gate_port_read(t->port, &bits) != GR_OK)
+				continue;
+			bits &= t->mask;
+			if (bits == t->last)
+				continue;
+			t->last = bits;
+			if ((t->type == 'R' && !bits) || (t->type == 'F' && bits))
+				continue;
+		}
+		pending |= 1 << i;
+	}
+
+	if (pending)
+		gate_event_post(GATE_EVT_SERIAL);
+}
+
+static GATE_TASK macro_gtask = {
+	.task = macro_task,
+	.period = SYSTICK_MS(MACRO_POLL_MS),
+};
+
+// -- parser --
+
+static void macro_error(PGM_P msg) {
+	fmt_str_P(PSTR("M Error. "));
+	fmt_str_P(msg);
+	putchar('\n');
+}
+
+/** Parse macro name at *p, upper case it in place
+ * @return name length, 0 -- invalid
+ */
+static uint8_t get_name(char **p) {
+	char *s = *p;
+	uint8_t n = 0;
+
+	while (isalnum((unsigned char) *s) || *s == '_') {
+		*s = toupper((unsigned char) *s);
+		s++;
+		n++;
+	}
+	*p = s;
+	return (n <= MACRO_NAME_LEN) ? n : 0;
+}
+
+/** Parse decimal number at *p
+ * @return false if no digits or overflow
+ */
+static bool get_u16(char **p, uint16_t *ret) {
+	char *s = *p;
+	uint32_t v = 0;
+
+	while (isdigit((unsigned char) *s)) {
+		v = v * 10 + (*s++ - '0');
+		if (v > 0xffff)
+			return false;
+	}
+	if (s == *p)
+		return false;
+
+	*p = s;
+	*ret = v;
+	return true;
+}
+
+/** Put "Mc<name>" of response
+ */
+static void put_cmd(char cmd, const char *name, uint8_t nlen) {
+	putchar('M');
+	putchar(cmd);
+	for (uint8_t i=0; i < nlen; i++)
+		putchar(name[i]);
+}
+
+/** Turn ';'-separated text into lines
+ * @return false if a line is an 'M' or 'B' command
+ */
+static bool make_lines(char *text, uint8_t tlen) {
+	bool start = true;
+
+	for (uint8_t i=0; i < tlen; i++) {
+		char c = text[i];
+
+		if (c == ';' || c == '\0') {
+			text[i] = '\n';
+			start = true;
+		} else if (start && c == '@') {
+			// tag prefix: "@tt "
+			while (i + 1 < tlen && isxdigit((unsigned char) text[i + 1]))
+				i++;
+		} else if (start && c != ' ') {
+			c = toupper((unsigned char) c);
+			if (c == 'M' || c == 'B')
+				return false;
+			start = false;
+		}
+	}
+	return true;
+}
+
+static void trig_add(char cmd, char *p, const char *name, uint8_t nlen, uint16_t rec) {
+	macro_trig_t *t = NULL;
+	uint16_t ms = 0;
+	uint8_t port_letter = 0, pin = 0, port = 0;
+	char type = 'T';
+
+	if (cmd == 'T') {
+		if (*p++ != ',' || !get_u16(&p, &ms) || *p ||
+				ms > MACRO_PERIOD_MAX) {
+			macro_error(PSTR("Invalid period"));
+			return;
+		}
+	} else if (*p) {
+		// ",Pn,e"
+		port_letter = toupper((unsigned char) p[1]);
+		pin = p[2] - '0';
+		type = toupper((unsigned char) p[4]);
+		if (strlen(p) != 5 || p[0] != ',' || pin > 7 || p[3] != ',' ||
+				(type != 'R' && type != 'F' && type != 'B')) {
+			macro_error(PSTR("Invalid format"));
+			return;
+		}
+		port = port_letter_number(port_letter);
+		if (!find_port(port)) {
+			macro_error(PSTR("Wrong port"));
+			return;
+		}
+	}
+
+	// drop old timer of the macro, or its trigger(s) on the same pin
+	for (uint8_t i=0; i < MACRO_TRIG_LEN; i++) {
+		macro_trig_t *it = trig + i;
+		bool same;
+
+		if (it->rec != rec)
+			same = false;
+		else if (cmd == 'T')
+			same = it->type == 'T';
+		else
+			same = it->type != 'T' && (!port_letter ||
+				(it->port == port && it->mask == (1 << pin)));
+
+		if (same) {
+			it->rec = MACRO_NONE;
+			pending &= ~(1 << i);
+		}
+		if (it->rec == MACRO_NONE && !t)
+			t = it;
+	}
+
+	if (ms || port_letter) {
+		if (!t) {
+			macro_error(PSTR("No free trigger"));
+			return;
+		}
+		t->type = type;
+		t->period = SYSTICK_MS(ms);
+		t->next = systick_get() + t->period;
+		t->port = port;
+		t->mask = 1 << pin;
+		if (port_letter && gate_port_read(port, &t->last) == GR_OK)
+			t->last &= t->mask;
+		t->rec = rec;
+	}
+
+	put_cmd(cmd, name, nlen);
+	if (cmd == 'T') {
+		putchar(',');
+		fmt_u16(ms);
+	} else if (port_letter) {
+		putchar(',');
+		putchar(port_letter);
+		fmt_u8(pin);
+		putchar(',');
+		putchar(type);
+	}
+	putchar('\n');
+}
+
+static void macro_list(void) {
+	uint16_t rec = MACRO_EE_START;
+	uint8_t size;
+
+	while ((size = rec_size(rec))) {
+		uint8_t nlen = ee_byte(rec + 1);
+
+		if (nlen != MACRO_DEAD) {
+			fmt_str_P(PSTR("M="));
+			for (uint8_t i=0; i < nlen; i++)
+				putchar(ee_byte(rec + MACRO_HDR + i));
+			putchar(',');
+			fmt_u8(size - MACRO_HDR - nlen);
+			putchar('\n');
+		}
+		rec += size;
+	}
+
+	fmt_str_P(PSTR("ML"));
+	fmt_u16(rec_free());
+	putchar('\n');
+}
+
+static void macro_command(void) {
+	char cmd = toupper((unsigned char) line[0]);
+	char *p = line + 1;
+	char *name = p;
+	uint8_t nlen;
+	uint16_t rec;
+
+	if (cmd == 'L' || cmd == 'C') {
+		if (*p) {
+			macro_error(PSTR("Invalid format"));
+			return;
+		}
+		if (cmd == 'L') {
+			macro_list();
+			return;
+		}
+		for (uint8_t i=0; i < MACRO_TRIG_LEN; i++)
+			trig[i].rec = MACRO_NONE;
+		pending = 0;
+		run_left = 0;
+		fmt_str_P(PSTR("MC\n"));
+		return;
+	}
+
+	if (cmd != 'W' && cmd != 'X' && cmd != 'D' && cmd != 'T' && cmd != 'E') {
+		macro_error(PSTR("Unknown command"));
+		return;
+	}
+
+	nlen = get_name(&p);
+	if (!nlen) {
+		macro_error(PSTR("Invalid name"));
+		return;
+	}
+
+	if (cmd == 'W') {
+		uint8_t tlen = line_len - (p + 1 - line) + 1;
+
+		if (*p != ':') {
+			macro_error(PSTR("Invalid format"));
+			return;
+		}
+		if (tlen > MACRO_TEXT_LEN) {
+			macro_error(PSTR("Too long"));
+			return;
+		}
+		if (!make_lines(p + 1, tlen)) {
+			macro_error(PSTR("Nested command"));
+			return;
+		}
+		if (!rec_write(name, nlen, p + 1, tlen)) {
+			macro_error(PSTR("No space"));
+			return;
+		}
+		put_cmd(cmd, name, nlen);
+		putchar('\n');
+		return;
+	}
+
+	rec = rec_find(name, nlen);
+	if (rec == MACRO_NONE) {
+		macro_error(PSTR("No macro"));
+		return;
+	}
+
+	switch (cmd) {
+		case 'X':
+		case 'D':
+			if (*p) {
+				macro_error(PSTR("Invalid format"));
+				return;
+			}
+			if (cmd == 'X') {
+				now_rec = rec;
+				pending |= 1 << MACRO_RUN_NOW;
+			} else {
+				rec_kill(rec);
+			}
+			put_cmd(cmd, name, nlen);
+			putchar('\n');
+			break;
+
+		default:
+			trig_add(cmd, p, name, nlen, rec);
+	}
+}
+
+static bool macro_parser(char c, bool reinit) {
+	if (reinit) {
+		line_len = 0;
+		line_over = false;
+		return false;
+	}
+
+	if (c != '\n') {
+		if (line_len < sizeof(line) - 1)
+			line[line_len++] = c;
+		else
+			line_over = true;
+		return false;
+	}
+
+	line[line_len] = '\0';
+	if (line_over)
+		macro_error(PSTR("Too long"));
+	else
+		macro_command();
+	return true;
+}
+
+static parser_t macroparser = PARSER_INIT('M', "command macros", macro_parser);
+
+void register_macro(void) {
+	for (uint8_t i=0; i < MACRO_TRIG_LEN; i++)
+		trig[i].rec = MACRO_NONE;
+
+	rec_fixup();
+	register_parser(&macroparser);
+	gate_task_register(&macro_gtask);
+}
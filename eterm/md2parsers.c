@@ -30,25 +30,28 @@
 #include "eterm.h"
 #include "core/ports.h"
 #include "hal/motor.h"
+#include "lib/fmt.h"
 
 #include <stdlib.h>
 #include <math.h>
 
-#define ILLIGAL_PORT  100
-
 // -- helpers --
 
 static inline void md2_setspeed(int16_t left, int16_t right)
 {
 	if (abs(left) > 100 || abs(right) > 100) {
-		printf("ERR in DriveLR cmd - only -100..+100 values allowed\n");
+		fmt_str_P(PSTR("ERR in DriveLR cmd - only -100..+100 values allowed\n"));
 		return;
 	}
 	motor_set_direction(0, left < 0);
 	motor_set_direction(1, right < 0);
 	motor_set_pwm(0, abs(left) * 255/100);
 	motor_set_pwm(1, abs(right) * 255/100);
-	printf("Drv(%d,%d)\n", left, right);
+	fmt_str_P(PSTR("Drv("));
+	fmt_s16(left);
+	putchar(',');
+	fmt_s16(right);
+	fmt_str_P(PSTR(")\n"));
 }
 
 // -- parser --
@@ -64,30 +67,29 @@ typedef enum {
 
 static bool md2_control_parser(char c, bool reinit) {
 	static state_cmd_mcp state_cmd;
-	static uint8_t _cmd=' ';
 	static int16_t val_L=0;
 	static int16_t val_R=0;
 	static int16_t value=0;
 	static bool minux_flag=false;
+	static uint8_t digits=0;
 	
 	if (reinit) {
 		// Clear machine
 		state_cmd = MCP_GET_COMMAND;
-		_cmd = ' ';
 		val_L = 999;
 		val_R = 999;
 		value = 0;
 		minux_flag = false;
+		digits = 0;
 		return false;
-	}
-
+	}
+
 	//printf("%% st%d c=%c\n", state_cmd, c);
 
 	switch (state_cmd) {
 		case MCP_GET_COMMAND:
 			switch (c) {
 				case 'L':
-					_cmd = c;
 					state_cmd = MCP_GET_R;
 					return false;
 
@@ -96,7 +98,7 @@ static bool md2_control_parser(char c, bool reinit) {
 					return false;
 
 				case '\n':
-					printf("ERR01 in Drv cmd - wrong command\n");
+					fmt_str_P(PSTR("ERR01 in Drv cmd - wrong command\n"));
 					return true;
 
 				default:
@@ -118,6 +120,7 @@ static bool md2_control_parser(char c, bool reinit) {
 				case '8':
 				case '9':
 					value = value*10+c-'0';
+					digits++;
 					if (value > 100)
 						state_cmd = MCP_ERROR;
 					return false;
@@ -127,30 +130,36 @@ static bool md2_control_parser(char c, bool reinit) {
 					return false;
 
 				case '\n':
-					if (val_L == 999)
-						printf("ERR03 in DrvLR cmd - not enough params\n");
+					if (val_L == 999 || !digits) {
+						fmt_str_P(PSTR("ERR03 in DrvLR cmd - not enough params\n"));
+						return true;
+					}
 					val_R = (minux_flag)? -value : value;
 					md2_setspeed(val_L, val_R);
 					return true;
 
 				case '-':
+					// sign goes before the digits, once
+					if (minux_flag || digits)
+						state_cmd = MCP_ERROR;
 					minux_flag = true;
 					return false;
 
 				case ',':
-					if (val_R < 999) {
-						printf("ERR04 in DrvLR cmd - to many params\n");
-						state_cmd = MCP_ERROR;
+					if (val_L != 999) {
+						fmt_str_P(PSTR("ERR04 in DrvLR cmd - to many params\n"));
+						state_cmd = MCP_WAIT_EOL;
 						return false;
 					}
-					if (val_L != 999) {
-						printf("ERR05 in DrvLR cmd - first param ommited\n");
-						state_cmd = MCP_ERROR;
+					if (!digits) {
+						fmt_str_P(PSTR("ERR05 in DrvLR cmd - first param ommited\n"));
+						state_cmd = MCP_WAIT_EOL;
 						return false;
 					}
 					val_L = (minux_flag)? -value : value;
 					value = 0;
 					minux_flag = false;
+					digits = 0;
 					return false;
 
 				default:
@@ -166,7 +175,7 @@ static bool md2_control_parser(char c, bool reinit) {
 					return false;
 
 				case '\n':
-					printf("ERR06 in Drv cmd\n");
+					fmt_str_P(PSTR("ERR06 in Drv cmd\n"));
 					return true;
 
 				default:
@@ -174,7 +183,7 @@ static bool md2_control_parser(char c, bool reinit) {
 					return false;
 			}
 			break;
-
+
 		case MCP_GET_v:
 			switch (c) {
 				case 'v':
@@ -182,7 +191,7 @@ static bool md2_control_parser(char c, bool reinit) {
 					return false;
 
 				case '\n':
-					printf("ERR06 in Drv cmd\n");
+					fmt_str_P(PSTR("ERR06 in Drv cmd\n"));
 					return true;
 
 				default:
@@ -190,7 +199,11 @@ static bool md2_control_parser(char c, bool reinit) {
 					return false;
 			}
 			break;
-
+
+
+		case MCP_WAIT_EOL:
+			// error is already reported
+			return c == '\n';
 
 		default:
 			state_cmd = MCP_ERROR;
@@ -200,7 +213,7 @@ static bool md2_control_parser(char c, bool reinit) {
 
 	if (c != '\n')
 		return false;
-	printf("ERR09 in Drv cmd\n");
+	fmt_str_P(PSTR("ERR09 in Drv cmd\n"));
 	return true;
 }
 
@@ -33,6 +33,7 @@
 
 #include "eterm.h"
 #include "hal/servo.h"
+#include "lib/fmt.h"
 
 /// Debug print
 #ifndef NDEBUG
@@ -53,8 +54,8 @@ static bool servo_move_parser(char c, bool reinit) {
 	static uint16_t _servo_target[SERVO_LEN];
 	static uint16_t _servo_maxspeed[SERVO_LEN];
 	static uint16_t _time2go;
-	static uint16_t _servo=0;
-	static uint16_t _num=0;
+	static uint8_t _servo=0;
+	static uint32_t _num=0; ///< > 0xffff -- too big
 	static uint8_t _cmd=' ';
 	
 	if (reinit) {
@@ -75,23 +76,28 @@ static bool servo_move_parser(char c, bool reinit) {
 	switch (state_cmd) {
 		case SMP_PARSE_NUMBER:
 			if (c >= '0' && c <= '9') {
-				_num = _num*10 + (c - '0');
+				if (_num <= 0xffff)
+					_num = _num*10 + (c - '0');
 				state_cmd = SMP_PARSE_NUMBER;
 			} else {
+				if (_num > 0xffff || (_cmd == '#' && _num >= SERVO_LEN)) {
+					// don't apply the rest to the previous servo
+					state_cmd = SMP_ERROR;
+					break;
+				}
 				if (_cmd == '#') {
-					if(_num < SERVO_LEN)
-						_servo = _num;
+					_servo = _num;
 				} else if (_cmd == 'P') {
 					if (_num <= 2500 && _num >= 500) {
 						_servo_target[_servo] = _num;
-						debug("%% pos[%d]=%d\n", _servo, _num);
+						debug("%% pos[%d]=%d\n", _servo, (int) _num);
 					}
 				} else if (_cmd == 'S') {
 					_servo_maxspeed[_servo] = _num;
-					debug("%% spd[%d]=%d\n", _servo, _num);
+					debug("%% spd[%d]=%d\n", _servo, (int) _num);
 				} else if (_cmd == 'T') {
 					_time2go = _num;
-					debug("%% time=%d\n", _num);
+					debug("%% time=%d\n", (int) _num);
 				}
 				state_cmd = SMP_GET_COMMAND;
 			}
@@ -132,7 +138,7 @@ static bool servo_move_parser(char c, bool reinit) {
 
 	if (c != '\n')
 		return false;
-	printf("ERR in # cmd\n");
+	fmt_str_P(PSTR("ERR in # cmd\n"));
 	return true;
 }
 
@@ -152,9 +158,9 @@ static bool query_status_parser(char c, bool reinit) {
 	if (servo_num == QSP_SELECT_CMD) {
 		if (c == '\n') {
 			if (servo_is_done()) {
-				printf(".");
+				putchar('.');
 			} else {
-				printf("+");
+				putchar('+');
 			}
 			return true;
 		}
@@ -170,14 +176,14 @@ static bool query_status_parser(char c, bool reinit) {
 	if (servo_num == QSP_Q_ERROR) {
 		if (c != '\n')
 			return false;
-		printf("ERR in Q cmd\n");
+		fmt_str_P(PSTR("ERR in Q cmd\n"));
 		return true;
 	}
 	
 	if (servo_num == QSP_QP_SN_ERROR) {
 		if (c != '\n')
 			return false;
-		printf("ERR in QP cmd servo #\n");
+		fmt_str_P(PSTR("ERR in QP cmd servo #\n"));
 		return true;
 	}
 
@@ -30,8 +30,7 @@
 #include "eterm.h"
 #include "core/ports.h"
 #include "hal/adc.h"
-
-#define ILLIGAL_PORT  100
+#include "lib/fmt.h"
 
 // -- helpers --
 
@@ -39,15 +38,15 @@ static inline void adc_ref(uint8_t _ref)
 {
 	if (_ref == 'E') {
 		adc_config |= 0x00; // External
-		printf("AdcRef=Ext\n");
+		fmt_str_P(PSTR("AdcRef=Ext\n"));
 	}
 	if (_ref == 'A') {
 		adc_config |= 0x01; // AVCC
-		printf("AdcRef=AVCC\n");
+		fmt_str_P(PSTR("AdcRef=AVCC\n"));
 	}
 	if (_ref == 'I') {
 		adc_config |= 0x02; // Internal
-		printf("AdcRef=Int\n");
+		fmt_str_P(PSTR("AdcRef=Int\n"));
 	}
 	adc_reconfigure(adc_get_mask());
 }
@@ -56,11 +55,11 @@ static inline void adc_bits(uint8_t _ref)
 {
 	if (_ref == '1') {
 		adc_config |= 0x04; //10 bit
-		printf("AdcBits=10\n");
+		fmt_str_P(PSTR("AdcBits=10\n"));
 	}
 	if (_ref == '8') {
 		adc_config &= ~0x04; //8 bit
-		printf("AdcBits=8\n");
+		fmt_str_P(PSTR("AdcBits=8\n"));
 	}
 	adc_reconfigure(adc_get_mask());
 }
@@ -78,7 +77,8 @@ static inline const uint8_t pcp_adc_port(void)
 #endif
 }
 
-static const uint8_t pcp_port_number(uint8_t _port)
+// also used by macro port triggers (macroparser.c)
+uint8_t port_letter_number(uint8_t _port)
 {
 #ifdef OR_AVR_M32_D
 	switch (_port) {
@@ -102,12 +102,27 @@ static const uint8_t pcp_port_number(uint8_t _port)
 	}
 #endif
 
-	printf("ERR in P cmd - wrong port id for this controller\n");
 	return ILLIGAL_PORT;
 }
 
+static uint8_t pcp_port_number(uint8_t _port)
+{
+	uint8_t _port_num=port_letter_number(_port);
+	if (_port_num == ILLIGAL_PORT)
+		fmt_str_P(PSTR("ERR in P cmd - wrong port id for this controller\n"));
+	return _port_num;
+}
+
 // -- common --
 
+/** Put "<port><pin>" of response
+ */
+static void pcp_pin(uint8_t _port, uint8_t _pin)
+{
+	putchar(_port);
+	fmt_u8(_pin);
+}
+
 static inline void pcp_mode(uint8_t _port, uint8_t _pin, uint8_t _mode)
 {
 	uint8_t _port_num=pcp_port_number(_port);
@@ -125,20 +140,28 @@ static inline void pcp_mode(uint8_t _port, uint8_t _pin, uint8_t _mode)
 		adc_reconfigure(adc_mask);
 
 		if (_mode == 'A') {
-			printf("PinMode%c%d=ADC\n", _port, _pin);
+			fmt_str_P(PSTR("PinMode"));
+			pcp_pin(_port, _pin);
+			fmt_str_P(PSTR("=ADC\n"));
 			return;
 		}
 	}
 
 	if (_mode == 'A') {
-		printf("ERR in PinMode cmd - only %c port on this controller has ADC function\n", adc_port);
+		fmt_str_P(PSTR("ERR in PinMode cmd - only "));
+		putchar(adc_port);
+		fmt_str_P(PSTR(" port on this controller has ADC function\n"));
 		return;
 	} else if (_mode == 'I') {
 		gate_port_config(_port_num, 1<<_pin, 0);
-		printf("PinMode%c%d=In\n", _port, _pin);
+		fmt_str_P(PSTR("PinMode"));
+		pcp_pin(_port, _pin);
+		fmt_str_P(PSTR("=In\n"));
 	} else if (_mode == 'O') {
 		gate_port_config(_port_num, 1<<_pin, 0xFF);
-		printf("PinMode%c%d=Out\n", _port, _pin);
+		fmt_str_P(PSTR("PinMode"));
+		pcp_pin(_port, _pin);
+		fmt_str_P(PSTR("=Out\n"));
 	}
 }
 
@@ -152,7 +175,7 @@ static inline void pcp_set(uint8_t _port, uint8_t _pin, uint8_t _value)
 	if (_port == adc_port) {
 		uint8_t adc_mask=adc_get_mask();
 		if (adc_mask & (1<<_pin)) {
-			printf("ERR in PinSet cmd - write to ADC is prohibited\n");
+			fmt_str_P(PSTR("ERR in PinSet cmd - write to ADC is prohibited\n"));
 			return;
 		}
 	}
@@ -162,7 +185,10 @@ static inline void pcp_set(uint8_t _port, uint8_t _pin, uint8_t _value)
 		_value = 0xFF;
 
 	gate_port_write(_port_num, 1<<_pin, _value);
-	printf("%c%d=%d\n", _port, _pin, _value > 0);
+	pcp_pin(_port, _pin);
+	putchar('=');
+	putchar(_value ? '1' : '0');
+	putchar('\n');
 }
 
 static inline void pcp_get(uint8_t _port, uint8_t _pin)
@@ -177,25 +203,31 @@ static inline void pcp_get(uint8_t _port, uint8_t _pin)
 		if (adc_mask & (1<<_pin)) {
 			uint32_t value=adc_get_result(_pin);
 
-			value = 330*value; //*3.3V*100
-
+			// *3.3V*100 / full scale, as multiply and shift:
+			// 21141 = 330 * 65536 / 1023, 84812 = 330 * 65536 / 255,
+			// both exact for every adc value
 			if (adc_is_10bit()) {
 				// 10bit
-				value = value / 1023; //1024; // div by power of 2 is faster
+				value = (value * 21141) >> 16;
 			} else {
 				// 8bit
-				value = value / 255; //256;
+				value = (value * 84812) >> 16;
 			}
 
-			printf("%c%d:%d.%02d\n", _port, _pin,
-					(uint8_t) (value/100), (uint8_t) (value%100));
+			pcp_pin(_port, _pin);
+			putchar(':');
+			fmt_fixed(value, 2);
+			putchar('\n');
 			return;
 		}
 	}
 
 	uint8_t result;
 	gate_port_read(_port_num, &result);
-	printf("%c%d:%d\n", _port, _pin, (result & (1<<_pin)) > 0);
+	pcp_pin(_port, _pin);
+	putchar(':');
+	putchar((result & (1<<_pin)) ? '1' : '0');
+	putchar('\n');
 }
 
 // -- parser --
@@ -245,7 +277,7 @@ static bool pin_control_parser(char c, bool reinit) {
 					return false;
 
 				case '\n':
-					printf("ERR01 in P cmd - wrong command\n");
+					fmt_str_P(PSTR("ERR01 in P cmd - wrong command\n"));
 					return true;
 
 				default:
@@ -275,7 +307,7 @@ static bool pin_control_parser(char c, bool reinit) {
 					return false;
 
 				case '\n':
-					printf("ERR02 in P cmd - wrong port\n");
+					fmt_str_P(PSTR("ERR02 in P cmd - wrong port\n"));
 					return true;
 
 				default:
@@ -301,7 +333,7 @@ static bool pin_control_parser(char c, bool reinit) {
 					return false;
 
 				case '\n':
-					printf("ERR03 in P cmd - wrong pin\n");
+					fmt_str_P(PSTR("ERR03 in P cmd - wrong pin\n"));
 					return true;
 
 				default:
@@ -338,7 +370,7 @@ static bool pin_control_parser(char c, bool reinit) {
 					return false;
 
 				case '\n':
-					printf("ERR04 in P cmd - wrong value\n");
+					fmt_str_P(PSTR("ERR04 in P cmd - wrong value\n"));
 					return true;
 
 				default:
@@ -380,7 +412,7 @@ static bool pin_control_parser(char c, bool reinit) {
 					return false;
 
 				case '\n':
-					printf("ERR05 in Pin cmd\n");
+					fmt_str_P(PSTR("ERR05 in Pin cmd\n"));
 					return true;
 
 				default:
@@ -396,7 +428,7 @@ static bool pin_control_parser(char c, bool reinit) {
 					return false;
 
 				case '\n':
-					printf("ERR06 in PinGet cmd\n");
+					fmt_str_P(PSTR("ERR06 in PinGet cmd\n"));
 					return true;
 
 				default:
@@ -412,7 +444,7 @@ static bool pin_control_parser(char c, bool reinit) {
 					return false;
 
 				case '\n':
-					printf("ERR07 in PinMode cmd\n");
+					fmt_str_P(PSTR("ERR07 in PinMode cmd\n"));
 					return true;
 
 				default:
@@ -428,7 +460,7 @@ static bool pin_control_parser(char c, bool reinit) {
 					return false;
 
 				case '\n':
-					printf("ERR08 in PinMode cmd\n");
+					fmt_str_P(PSTR("ERR08 in PinMode cmd\n"));
 					return true;
 
 				default:
@@ -445,7 +477,7 @@ static bool pin_control_parser(char c, bool reinit) {
 
 	if (c != '\n')
 		return false;
-	printf("ERR09 in P cmd\n");
+	fmt_str_P(PSTR("ERR09 in P cmd\n"));
 	return true;
 }
 
@@ -483,7 +515,7 @@ static bool adc_config_parser(char c, bool reinit) {
 					return false;
 
 				case '\n':
-					printf("ERR01 in A cmd - wrong command\n");
+					fmt_str_P(PSTR("ERR01 in A cmd - wrong command\n"));
 					return true;
 
 				default:
@@ -520,7 +552,7 @@ static bool adc_config_parser(char c, bool reinit) {
 					return false;
 
 				case '\n':
-					printf("ERR04 in A cmd - wrong value\n");
+					fmt_str_P(PSTR("ERR04 in A cmd - wrong value\n"));
 					return true;
 
 				default:
@@ -553,7 +585,7 @@ static bool adc_config_parser(char c, bool reinit) {
 
 	if (c != '\n')
 		return false;
-	printf("ERR09 in A cmd\n");
+	fmt_str_P(PSTR("ERR09 in A cmd\n"));
 	return true;
 }
 
@@ -8,10 +8,34 @@ ETERMLIB_SRC = ${ORFA}/eterm/eterm.c \
 			   ${ORFA}/eterm/portparsers.c \
 			   ${ORFA}/eterm/wdtparser.c
 
-ifeq ($(PLATFORM),OR_AVR_M32_D)
-	ETERMLIB_SRC += ${ORFA}/eterm/md2parsers.c
+ifeq ($(SCHED_STATS),yes)
+	ETERMLIB_SRC += ${ORFA}/eterm/schedparser.c
+endif
+
+ifeq ($(I2C_STATS),yes)
+	ETERMLIB_SRC += ${ORFA}/eterm/i2cstatsparser.c
+endif
+
+ifeq ($(MACROS),yes)
+	ETERMLIB_SRC += ${ORFA}/eterm/macroparser.c
+	DEFINES += -DETERM_MACROS
+endif
+
+ifeq ($(TELEMETRY),yes)
+	ETERMLIB_SRC += ${ORFA}/eterm/telemetry.c
+	DEFINES += -DETERM_TELEMETRY
+endif
+
+ifeq ($(BINMODE),yes)
+	DEFINES += -DETERM_BINMODE
 endif
-ifeq ($(PLATFORM),OR_AVR_M128_DS)
+
+# telemetry frames use binmode.c frame output
+ifneq ($(filter yes,$(BINMODE) $(TELEMETRY)),)
+	ETERMLIB_SRC += ${ORFA}/eterm/binmode.c
+endif
+
+ifneq ($(filter motor,$(ADAPTERS)),)
 	ETERMLIB_SRC += ${ORFA}/eterm/md2parsers.c
 endif
 
@@ -0,0 +1,122 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Scheduler statistics parser
+ *
+ * Parsers list:
+ *   - T  -- print scheduler statistics
+ *   - TR -- reset scheduler statistics
+ *
+ * Output:
+ * @code
+ * T idle=<percent> total=<cycles>
+ * TH <hist0>,<hist1>,...
+ * T<n> <calls> <total cycles> <max cycles>
+ * @endcode
+ * Task 0 is the supertask.
+ *
+ * @file schedparser.c
+ */
+
+#include "eterm.h"
+#include "core/scheduler.h"
+#include "lib/fmt.h"
+
+static void print_task(uint8_t n, GATE_TASK_STATS *st)
+{
+	putchar('T');
+	fmt_u8(n);
+	putchar(' ');
+	fmt_u16(st->calls);
+	putchar(' ');
+	fmt_u32(st->cycles);
+	putchar(' ');
+	fmt_u32(st->cycles_max);
+	putchar('\n');
+}
+
+static void print_stats(void)
+{
+	uint32_t total = gate_sched_stats.total_cycles;
+	uint8_t idle = 0;
+	GATE_TASK *task;
+
+	if (total) {
+		// scale down to avoid 32-bit overflow
+		idle = (gate_sched_stats.idle_cycles >> 8) * 100 / ((total >> 8) + 1);
+	}
+
+	fmt_str_P(PSTR("T idle="));
+	fmt_u8(idle);
+	fmt_str_P(PSTR("% total="));
+	fmt_u32(total);
+	putchar('\n');
+
+	fmt_str_P(PSTR("TH"));
+	for (uint8_t i=0; i < GATE_STATS_HIST_LEN; i++) {
+		putchar(i ? ',' : ' ');
+		fmt_u16(gate_sched_stats.loop_hist[i]);
+	}
+	putchar('\n');
+
+	print_task(0, &gate_sched_stats.super);
+	for (uint8_t i=0; (task = gate_task_nth(i)); i++) {
+		print_task(i + 1, &task->stats);
+	}
+}
+
+static bool sched_parser(char c, bool reinit) {
+	static bool reset;
+
+	if (reinit) {
+		reset = false;
+		return false;
+	}
+
+	if (toupper(c) == 'R')
+		reset = true;
+
+	if (c == '\n') {
+		if (reset) {
+			gate_sched_stats_reset();
+			fmt_str_P(PSTR("TR\n"));
+		} else {
+			print_stats();
+		}
+		return true;
+	}
+	return false;
+}
+
+// -- table --
+
+static parser_t schedparsers[] = {
+	PARSER_INIT('T', "scheduler statistics", sched_parser),
+};
+
+void register_sched(void) {
+	for (uint8_t i=0; i < ARRAY_SIZE(schedparsers); i++) {
+		register_parser(schedparsers + i);
+	}
+}
+
@@ -30,64 +30,117 @@
  *   - L -- get/set local
  *   - C -- get/set i2c bus speed
  *   - S -- i2c request
+ *   - B -- binary mode (binmode.c, BINMODE = yes)
+ *
+ * 'S' requests are queued and run in order by serialgate_queue_run(),
+ * one i2c transfer per segment; the bus works from the TWI interrupt
+ * meanwhile, and the answer line is put when all segments are done.
+ * Tagged requests ("@tt S ...") are answered later with "@tt SW..P",
+ * so a host may keep several of them in flight; commands that don't
+ * touch the bus answer at once, possibly before them. Commands after
+ * an untagged 'S' wait for its answer (serialgate_hold()).
+ * A request longer than SG_QUEUE_DATA, or reading more than
+ * SG_RESULT_LEN bytes with segment headers, answers "SEP", as does a
+ * read segment without exactly one non-zero count ("S 41").
+ *
+ * "S aa dd.. R nn" writes dd.. to aa, then reads nn bytes from aa+1
+ * after a repeated START, in one bus transaction (register read
+ * without a STOP another master could take the bus at). The answer is
+ * that of "S aa dd.. S aa+1 nn": "SWA..SR..".
+ *
+ * A segment that fails on the bus (I2C_E_ARB, I2C_E_BUS, I2C_E_TIMEOUT)
+ * ends the request: "SW..E06P" -- "E" and the status in hex. 'X'
+ * answers "X", or "XE04" if the bus is still held low.
  *
  * @file sgparsers.c
  * @author Vladimir Ermakov <vooon341@gmail.com>
  */
 
 #include "eterm.h"
-#include "lib/cbuf.h"
 #include "lib/hex.h"
+#include "lib/fmt.h"
 #include "hal/i2c.h"
+#include "hal/serial.h"
 #include <util/atomic.h>
 
 #include <core/i2cadapter.h>
 
 #define PROTOCOL_VERSION_STRING "V1.2"
+
+/// Tagged request queue length
+#ifndef SG_QUEUE_LEN
+#define SG_QUEUE_LEN   4
+#endif
+
+/// Bytes per queued request: 1 + segment length for each segment (< 128)
+#ifndef SG_QUEUE_DATA
+#define SG_QUEUE_DATA  32
+#endif
+
+/// Answer of the running request: 1 + bytes read for each segment
+#ifndef SG_RESULT_LEN
+#define SG_RESULT_LEN  72
+#endif
+
+/// Read bytes hex-encoded per serial_write()
+#define SG_HEX_CHUNK   16
+
+#define SG_OVERFLOW    0xff
 #define is_i2c_read(addr) ((addr)&0x01)
 
+/// Segment header: write, then read after repeated START ('R')
+#define SG_SEG_REP     0x80
+#define seg_len(hdr)   ((hdr) & ~SG_SEG_REP)
+
 // -- common --
 
 static uint8_t byte;
-static uint8_t addr;
-static uint8_t count;
-static uint8_t read_count;
-static cbf_t iobuff;
 
+typedef struct {
+	int16_t tag;  ///< ETERM_NO_TAG -- untagged
+	uint8_t len;  ///< bytes used in data, SG_OVERFLOW -- too long
+	uint8_t rlen; ///< bytes of result
+	uint8_t data[SG_QUEUE_DATA]; ///< segments: [n][addr][data...], 'R' -- [n|SG_SEG_REP][addr][data...][count]
+} sg_request_t;
+
+static sg_request_t queue[SG_QUEUE_LEN];
+static uint8_t q_head;
+static uint8_t q_count;
+static uint8_t q_untagged;
+static sg_request_t *q_new; ///< request being parsed
+static uint8_t q_seg;       ///< its segment being parsed
+static uint8_t q_rpos;      ///< read count of the segment, after 'R'
+
+// running request: head of the queue
+static i2c_xfer_t xfer;
+static bool q_busy;         ///< xfer is submitted
+static uint8_t q_pos;       ///< segment of xfer
+static uint8_t result[SG_RESULT_LEN]; ///< [acks] and/or [n][data...] for each segment
+static uint8_t r_len;
+static uint8_t r_status;    ///< bus error that ended the request
+
+/** Collect hex digits in pairs, other chars are skipped
+ * @return true when *ret holds a new byte
+ */
 static bool get_xbyte(char c, uint8_t *ret, bool reinit) {
+	static char pair[2];
 	static bool step;
-	int8_t xi = xtoi(c);
 
 	if (reinit) {
 		step = false;
 		return false;
 	}
 
-	if (c == '\n')
+	if (xtoi(c) < 0)
 		return false;
 
+	pair[step] = c;
 	if (!step) {
-		*ret = xi << 4;
 		step = true;
 		return false;
-	} else {
-		*ret |= xi;
-		step = false;
-		return true;
 	}
-}
-
-static bool master_rx_handler(uint8_t c) {
-	cbf_put(&iobuff, c);
-	count++;
-	return count < read_count;
-}
-
-static bool master_tx_handler(uint8_t *c, bool *ack) {
-	bool ack_ = !cbf_isempty(&iobuff);
-	*c = cbf_get(&iobuff);
-	count++;
-	return ack_;
+	step = false;
+	return hex_decode(ret, pair, 1);
 }
 
 // -- parsers --
@@ -109,18 +162,29 @@ bool version_parser(char c, bool reinit) {
 
 	if (c == '\n') {
 		if (type)
-			puts("V ORFA " ORFA_VERSION_STRING);
+			fmt_str_P(PSTR("V ORFA " ORFA_VERSION_STRING "\n"));
 		else
-			puts(PROTOCOL_VERSION_STRING);
+			fmt_str_P(PSTR(PROTOCOL_VERSION_STRING "\n"));
 		return true;
 	}
 	return false;
 }
 
+/** Put "E" and status
+ */
+static void put_error(uint8_t status) {
+	putchar('E');
+	fmt_hex8(status);
+}
+
 bool clearbus_parser(char c, bool reinit) {
 	if (c == '\n') {
-		i2c_clearbus();
-		puts("X");
+		uint8_t status = i2c_clearbus();
+
+		putchar('X');
+		if (status != I2C_E_OK)
+			put_error(status);
+		putchar('\n');
 		return true;
 	}
 	return false;
@@ -140,8 +204,7 @@ bool local_parser(char c, bool reinit) {
 	if (c == '\n') {
 		byte = i2c_get_local() << 1;
 		putchar('L');
-		putchar(itox(byte >> 4));
-		putchar(itox(byte & 0xf));
+		fmt_hex8(byte);
 		putchar('\n');
 		return true;
 	}
@@ -168,20 +231,232 @@ bool speed_parser(char c, bool reinit) {
 
 		speed = i2c_get_freq();
 		putchar('C');
-		putchar(itox((speed >> 12)));
-		putchar(itox((speed >> 8) & 0xf));
-		putchar(itox((speed >> 4) & 0xf));
-		putchar(itox((speed) & 0xf));
+		fmt_hex16(speed);
 		putchar('\n');
 		return true;
 	}
 	return false;
 }
 
+/** Start segment q_pos of the head request
+ */
+static void segment_start(const sg_request_t *r) {
+	const uint8_t *seg = r->data + q_pos;
+	uint8_t n = seg_len(seg[0]);
+
+	xfer.addr = seg[1] >> 1;
+	if (seg[0] & SG_SEG_REP) {
+		xfer.tx = seg + 2;
+		xfer.tx_len = n - 2;
+		xfer.rx_len = seg[n];
+		xfer.rx = result + r_len + 2;
+	} else if (is_i2c_read(seg[1])) {
+		xfer.tx_len = 0;
+		xfer.rx_len = seg[2];
+		xfer.rx = result + r_len + 1;
+	} else {
+		xfer.tx = seg + 2;
+		xfer.tx_len = n - 1;
+		xfer.rx_len = 0;
+	}
+	q_busy = true;
+	i2c_submit(&xfer);
+}
+
+/** Keep result of the finished segment
+ * Writes keep the count of acknowledged bytes, address included.
+ */
+static void segment_done(const sg_request_t *r) {
+	const uint8_t *seg = r->data + q_pos;
+
+	if (!is_i2c_read(seg[1])) {
+		bool addr_ack = xfer.tx_count || xfer.rx_count ||
+			xfer.status == I2C_E_OK || xfer.status == I2C_E_DATA_NACK;
+		result[r_len++] = addr_ack ? 1 + xfer.tx_count : 0;
+	}
+	if (is_i2c_read(seg[1]) || (seg[0] & SG_SEG_REP)) {
+		result[r_len] = xfer.rx_count;
+		r_len += 1 + xfer.rx_count;
+	}
+}
+
+/** Put the answer of the head request
+ */
+static void request_answer(const sg_request_t *r) {
+	const uint8_t *res = result;
+	int16_t out_tag = eterm_out_tag;
+
+	eterm_out_tag = r->tag;
+	if (r->len == SG_OVERFLOW) {
+		fmt_str_P(PSTR("SEP\n"));
+		eterm_out_tag = out_tag;
+		return;
+	}
+
+	for (uint8_t pos = 0; res < result + r_len; pos += 1 + seg_len(r->data[pos])) {
+		const uint8_t *seg = r->data + pos;
+		uint8_t n;
+
+		if (!is_i2c_read(seg[1])) {
+			n = *res++;
+			putchar('S');
+			putchar('W');
+			while (n--)
+				putchar('A');
+		}
+
+		if (is_i2c_read(seg[1]) || (seg[0] & SG_SEG_REP)) {
+			n = *res++;
+			putchar('S');
+			putchar('R');
+			while (n) {
+				char hex[2 * SG_HEX_CHUNK];
+				uint8_t chunk = (n < SG_HEX_CHUNK) ? n : SG_HEX_CHUNK;
+
+				serial_write((const uint8_t *) hex, hex_encode(hex, res, chunk) - hex);
+				res += chunk;
+				n -= chunk;
+			}
+		}
+	}
+	if (r_status != I2C_E_OK)
+		put_error(r_status);
+	fmt_str_P(PSTR("P\n"));
+	eterm_out_tag = out_tag;
+}
+
+bool serialgate_queue_run(void) {
+	sg_request_t *r = &queue[q_head];
+
+	if (!q_count)
+		return false;
+
+	if (q_busy) {
+		if (xfer.status == I2C_E_PENDING)
+			return false; // GATE_EVT_I2C_MASTER comes when done
+		q_busy = false;
+		segment_done(r);
+		q_pos += 1 + seg_len(r->data[q_pos]);
+
+		// NACKs are in the answer, bus errors end the request
+		if (xfer.status != I2C_E_OK && xfer.status != I2C_E_ADDR_NACK &&
+			xfer.status != I2C_E_DATA_NACK) {
+			r_status = xfer.status;
+			q_pos = r->len;
+		}
+	}
+
+	if (r->len != SG_OVERFLOW && q_pos < r->len) {
+		segment_start(r);
+		return xfer.status != I2C_E_PENDING;
+	}
+
+	request_answer(r);
+	if (r->tag == ETERM_NO_TAG)
+		q_untagged--;
+	q_pos = 0;
+	r_len = 0;
+	r_status = I2C_E_OK;
+	q_head = (q_head + 1) % SG_QUEUE_LEN;
+	q_count--;
+	return q_count != 0;
+}
+
+bool serialgate_hold(void) {
+	return q_untagged || q_count == SG_QUEUE_LEN;
+}
+
+/** Start segment of the request being parsed
+ */
+static void segment_begin(void) {
+	if (q_new->len == SG_OVERFLOW)
+		return;
+	if (q_new->len >= SG_QUEUE_DATA) {
+		q_new->len = SG_OVERFLOW;
+		return;
+	}
+	q_seg = q_new->len++;
+	q_new->data[q_seg] = 0;
+}
+
+/** Put byte to the segment being parsed
+ */
+static void segment_put(uint8_t b) {
+	if (q_new->len == SG_OVERFLOW)
+		return;
+	if (q_new->len >= SG_QUEUE_DATA) {
+		q_new->len = SG_OVERFLOW;
+		return;
+	}
+	q_new->data[q_new->len++] = b;
+	q_new->data[q_seg]++;
+}
+
+/** 'R' in the segment being parsed: read after its write
+ * Only one, in a write segment.
+ */
+static void segment_rep(void) {
+	uint8_t *seg = q_new->data + q_seg;
+
+	if (q_new->len == SG_OVERFLOW)
+		return;
+	if (!seg[0] || (seg[0] & SG_SEG_REP) || is_i2c_read(seg[1])) {
+		q_new->len = SG_OVERFLOW;
+		return;
+	}
+	seg[0] |= SG_SEG_REP;
+	q_rpos = q_new->len;
+}
+
+/** End segment of the request being parsed
+ * Empty segments are dropped. 'R' must be followed by one byte, a read
+ * segment holds one non-zero count after the address.
+ */
+static void segment_end(void) {
+	const uint8_t *seg = q_new->data + q_seg;
+	uint16_t rlen = q_new->rlen + 1;
+
+	if (q_new->len == SG_OVERFLOW)
+		return;
+	if (!seg[0]) {
+		q_new->len = q_seg;
+		return;
+	}
+
+	if (seg[0] & SG_SEG_REP) {
+		if (q_new->len != q_rpos + 1) {
+			q_new->len = SG_OVERFLOW;
+			return;
+		}
+		rlen += 1 + q_new->data[q_rpos];
+	} else if (is_i2c_read(seg[1])) {
+		// no count: nothing to read, the address would go out as a write
+		if (seg[0] != 2 || !seg[2]) {
+			q_new->len = SG_OVERFLOW;
+			return;
+		}
+		rlen += seg[2];
+	}
+	if (rlen > SG_RESULT_LEN)
+		q_new->len = SG_OVERFLOW;
+	else
+		q_new->rlen = rlen;
+}
+
 bool i2c_parser(char c, bool reinit) {
 
 	if (reinit) {
-		cbf_init(&iobuff);
+		// no room: wait for the oldest request
+		while (q_count == SG_QUEUE_LEN) {
+			if (!serialgate_queue_run() && q_busy)
+				i2c_wait(&xfer);
+		}
+
+		q_new = &queue[(q_head + q_count) % SG_QUEUE_LEN];
+		q_new->tag = eterm_tag();
+		q_new->len = 0;
+		q_new->rlen = 0;
+		segment_begin();
 		get_xbyte(c, &byte, true);
 		return false;
 	}
@@ -197,46 +472,28 @@ bool i2c_parser(char c, bool reinit) {
 	}
 
 	if (get_xbyte(c, &byte, false)) {
-		cbf_put(&iobuff, byte);
+		segment_put(byte);
 	}
 
-	if (c == '\n' || c == 'S') {
-		addr = cbf_get(&iobuff);
-		if (is_i2c_read(addr)) {
-			read_count = cbf_get(&iobuff);
-			
-			// flush
-			count = 0;
-			cbf_init(&iobuff);
-
-			i2c_request(addr >> 1);
+	if (c == 'R') {
+		segment_rep();
+		get_xbyte(c, &byte, true);
+		return false;
+	}
 
-			putchar('S');
-			putchar('R');
-			while (!cbf_isempty(&iobuff)) {
-				byte = cbf_get(&iobuff);
-				putchar(itox(byte >> 4));
-				putchar(itox(byte & 0xf));
-			}
-		} else {
-			// flush
-			count = 0;
+	if (c == '\n' || c == 'S') {
+		segment_end();
 
-			i2c_start_transmission(addr >> 1);
-			
-			putchar('S');
-			putchar('W');
-			for (int i=0; i < count; i++)
-				putchar('A');
-		}
-		
 		// reset
 		get_xbyte(c, &byte, true);
 
 		if (c == '\n') {
-			puts("P");
+			if (q_new->tag == ETERM_NO_TAG)
+				q_untagged++;
+			q_count++;
 			return true;
 		}
+		segment_begin();
 	}
 
 	return false;
@@ -250,11 +507,10 @@ parser_t sgparsers[] = {
 	PARSER_INIT('X', "clear i2c bus", clearbus_parser),
 	PARSER_INIT('L', "set/get local address", local_parser),
 	PARSER_INIT('C', "set/get i2c speed", speed_parser),
-	PARSER_INIT('S', "i2c request", i2c_parser),
+	PARSER_INIT('S', "i2c request (R -- read after write, @tt S -- no wait)", i2c_parser),
 };
 
 void register_serialgate(void) {
-	i2c_set_master_handlers(master_rx_handler, master_tx_handler);
 	for (int i=0; i < ARRAY_SIZE(sgparsers); i++) {
 		register_parser(sgparsers + i);
 	}
@@ -0,0 +1,433 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** eTerm push telemetry
+ * @file telemetry.c
+ *
+ * Frame format and 'R' command are described in telemetry.h.
+ */
+
+#include "eterm.h"
+#include "binmode.h"
+#include "telemetry.h"
+#include "core/ports.h"
+#include "core/scheduler.h"
+#include "hal/serial.h"
+#include "hal/systick.h"
+#include "lib/fmt.h"
+#include "lib/hex.h"
+#include <string.h>
+
+#ifdef HAVE_ADC
+#include "hal/adc.h"
+#endif
+#ifdef HAVE_SERVO
+#include "hal/servo.h"
+#endif
+#ifdef HAVE_MOTOR
+#include "hal/motor.h"
+#endif
+
+/// Task period without subscription, ticks
+#define TLM_IDLE_PERIOD   0x7fff
+#define TLM_PERIOD_MAX    ((uint16_t) (0x7fffUL * 1000 / SYSTICK_HZ))
+#define TLM_LINE_LEN      24
+
+// subscription
+static uint8_t amask;
+static uint8_t pmask;
+static uint16_t smask;
+static uint8_t flags;
+static bool delta;
+static bool active;
+
+static uint8_t seq;
+static uint8_t key_count;  ///< delta frames before next full one
+static uint16_t skipped;
+
+static uint8_t val[TLM_VALUES_LEN];  ///< fields of the current frame
+static uint8_t sent[TLM_VALUES_LEN]; ///< fields of the previous frame
+static uint8_t val_len;
+static uint8_t nfields;
+static uint8_t wide[(TLM_FIELDS + 7) / 8]; ///< bit per field: u16
+
+static char line[TLM_LINE_LEN];
+static uint8_t line_len;
+static bool line_over;
+
+static void tlm_task_func(void);
+
+static GATE_TASK tlm_task = {
+	.task = tlm_task_func,
+	.period = TLM_IDLE_PERIOD,
+};
+
+// -- fields --
+
+static void add8(uint8_t v) {
+	val[val_len++] = v;
+	wide[nfields / 8] &= ~(1 << (nfields % 8));
+	nfields++;
+}
+
+static void add16(uint16_t v) {
+	val[val_len++] = v & 0xff;
+	val[val_len++] = v >> 8;
+	wide[nfields / 8] |= 1 << (nfields % 8);
+	nfields++;
+}
+
+static inline uint8_t field_len(uint8_t i) {
+	return (wide[i / 8] & (1 << (i % 8))) ? 2 : 1;
+}
+
+/** Idle time since previous call, per mille
+ */
+static uint16_t idle_permille(void) {
+#ifdef GATE_SCHED_STATS
+	static uint32_t last_idle, last_total;
+	uint32_t idle = gate_sched_stats.idle_cycles - last_idle;
+	uint32_t total = gate_sched_stats.total_cycles - last_total;
+
+	if (gate_sched_stats.total_cycles < last_total) {
+		// statistics were reset
+		idle = gate_sched_stats.idle_cycles;
+		total = gate_sched_stats.total_cycles;
+	}
+	last_idle = gate_sched_stats.idle_cycles;
+	last_total = gate_sched_stats.total_cycles;
+
+	if (!total)
+		return 0xffff;
+	while (total > 0x400000UL) {
+		total >>= 1;
+		idle >>= 1;
+	}
+	return idle * 1000 / total;
+#else
+	return 0xffff;
+#endif
+}
+
+/** Read subscribed sources
+ */
+static void sample(void) {
+	uint8_t i;
+
+	val_len = 0;
+	nfields = 0;
+
+#ifdef HAVE_ADC
+	if (amask) {
+		uint16_t adc[ADC_LEN];
+
+		adc_get_frame(adc);
+		for (i=0; i < ADC_LEN; i++) {
+			if (amask & (1 << i))
+				add16(adc[i]);
+		}
+	}
+#endif
+
+	for (i=0; i < 8; i++) {
+		uint8_t bits = 0;
+
+		if (pmask & (1 << i)) {
+			gate_port_read(i, &bits);
+			add8(bits);
+		}
+	}
+
+#ifdef HAVE_SERVO
+	if (smask) {
+		uint16_t pos[SERVO_LEN];
+
+		servo_get_frame(pos);
+		for (i=0; i < TLM_SERVO_LEN && i < SERVO_LEN; i++) {
+			if (smask & (1U << i))
+				add16(pos[i]);
+		}
+	}
+#endif
+
+#ifdef HAVE_MOTOR
+	if (flags & TLM_FLAG_MOTOR) {
+		add8(motor_get_pwm(0));
+		add8(motor_get_pwm(1));
+		add8((motor_get_direction(0) ? 1 : 0) | (motor_get_direction(1) ? 2 : 0));
+	}
+#endif
+
+	if (flags & TLM_FLAG_STATS) {
+		add16(skipped);
+		add16(idle_permille());
+	}
+}
+
+// -- frames --
+
+static void send_frame(bool full) {
+	uint8_t i, j, off, bits = 0;
+
+	bin_frame_begin();
+	bin_frame_put(full ? TLM_FULL : TLM_DELTA);
+	bin_frame_put(seq++);
+
+	if (full) {
+		bin_frame_put(amask);
+		bin_frame_put(pmask);
+		bin_frame_put(smask & 0xff);
+		bin_frame_put(smask >> 8);
+		bin_frame_put(flags);
+		for (i=0; i < val_len; i++)
+			bin_frame_put(val[i]);
+	} else {
+		// bitmap of changed fields, then the fields
+		for (i=0, off=0; i < nfields; off += field_len(i), i++) {
+			if (memcmp(val + off, sent + off, field_len(i)))
+				bits |= 1 << (i % 8);
+			if (i % 8 == 7 || i == nfields - 1) {
+				bin_frame_put(bits);
+				bits = 0;
+			}
+		}
+		for (i=0, off=0; i < nfields; off += field_len(i), i++) {
+			if (!memcmp(val + off, sent + off, field_len(i)))
+				continue;
+			for (j=0; j < field_len(i); j++)
+				bin_frame_put(val[off + j]);
+		}
+	}
+
+	bin_frame_end();
+	memcpy(sent, val, val_len);
+}
+
+static void tlm_task_func(void) {
+	bool full;
+
+	if (!active || binmode_active)
+		return;
+
+	if (!serial_tx_isempty()) {
+		if (skipped < 0xffff)
+			skipped++;
+		return;
+	}
+
+	sample();
+	full = !delta || !key_count;
+	key_count = full ? TLM_KEYFRAME - 1 : key_count - 1;
+	send_frame(full);
+}
+
+// -- parser --
+
+static void tlm_error(PGM_P msg) {
+	fmt_str_P(PSTR("R Error. "));
+	fmt_str_P(msg);
+	putchar('\n');
+}
+
+/** Parse n hex digits at *p
+ */
+static bool get_hex(char **p, uint8_t n, uint16_t *ret) {
+	uint16_t v = 0;
+
+	while (n--) {
+		int8_t x = xtoi(**p);
+		if (x < 0)
+			return false;
+		v = (v << 4) | x;
+		(*p)++;
+	}
+	*ret = v;
+	return true;
+}
+
+/** Check that subscribed sources exist
+ */
+static bool sources_ok(uint8_t a, uint8_t pm, uint16_t s, uint8_t f) {
+#ifndef HAVE_ADC
+	if (a)
+		return false;
+#endif
+
+	for (uint8_t i=0; i < 8; i++) {
+		if ((pm & (1 << i)) && !find_port(i))
+			return false;
+	}
+
+#ifdef HAVE_SERVO
+#if SERVO_LEN < TLM_SERVO_LEN
+	if (s >> SERVO_LEN)
+		return false;
+#endif
+#else
+	if (s)
+		return false;
+#endif
+
+#ifndef HAVE_MOTOR
+	if (f & TLM_FLAG_MOTOR)
+		return false;
+#endif
+
+	return a || pm || s || f;
+}
+
+static void tlm_command(void) {
+	char *p = line;
+	uint8_t a = 0, pm = 0, f = 0;
+	uint16_t s = 0, v;
+	uint32_t ms = 0;
+	bool d = false, once = true;
+
+	while (*p) {
+		switch (toupper((unsigned char) *p++)) {
+			case ' ':
+				continue;
+			case 'A':
+				if (!get_hex(&p, 2, &v))
+					goto format;
+				a = v;
+				continue;
+			case 'P':
+				if (!get_hex(&p, 2, &v))
+					goto format;
+				pm = v;
+				continue;
+			case 'S':
+				if (!get_hex(&p, 4, &s))
+					goto format;
+				continue;
+			case 'M':
+				f |= TLM_FLAG_MOTOR;
+				continue;
+			case 'T':
+				f |= TLM_FLAG_STATS;
+				continue;
+			case 'D':
+				d = true;
+				continue;
+			case ',':
+				while (isdigit((unsigned char) *p)) {
+					if (ms > TLM_PERIOD_MAX)
+						break;
+					ms = ms * 10 + (*p++ - '0');
+				}
+				if (*p || !ms || ms > TLM_PERIOD_MAX) {
+					tlm_error(PSTR("Invalid period"));
+					return;
+				}
+				once = false;
+				continue;
+			default:
+				goto format;
+		}
+	}
+
+	if (once && !a && !pm && !s && !f) {
+		active = false;
+		tlm_task.period = TLM_IDLE_PERIOD;
+		fmt_str_P(PSTR("R=0,0\n"));
+		return;
+	}
+
+	if (!sources_ok(a, pm, s, f)) {
+		tlm_error(PSTR("No source"));
+		return;
+	}
+
+	if (once) {
+		// one full frame; a subscription goes on with a full frame
+		uint8_t a_ = amask, pm_ = pmask, f_ = flags;
+		uint16_t s_ = smask;
+
+		amask = a;
+		pmask = pm;
+		smask = s;
+		flags = f;
+		sample();
+		send_frame(true);
+
+		amask = a_;
+		pmask = pm_;
+		smask = s_;
+		flags = f_;
+		key_count = 0;
+		return;
+	}
+
+	amask = a;
+	pmask = pm;
+	smask = s;
+	flags = f;
+	delta = d;
+	key_count = 0;
+	active = true;
+	sample();
+
+	tlm_task.period = SYSTICK_MS(ms);
+	tlm_task.next_run = systick_get() + tlm_task.period;
+
+	fmt_str_P(PSTR("R="));
+	fmt_u8(2 + 5 + val_len + 2);
+	putchar(',');
+	fmt_u16(ms);
+	putchar('\n');
+	return;
+
+format:
+	tlm_error(PSTR("Invalid format"));
+}
+
+static bool tlm_parser(char c, bool reinit) {
+	if (reinit) {
+		line_len = 0;
+		line_over = false;
+		return false;
+	}
+
+	if (c != '\n') {
+		if (line_len < sizeof(line) - 1)
+			line[line_len++] = c;
+		else
+			line_over = true;
+		return false;
+	}
+
+	line[line_len] = '\0';
+	if (line_over)
+		tlm_error(PSTR("Invalid format"));
+	else
+		tlm_command();
+	return true;
+}
+
+static parser_t tlmparser = PARSER_INIT('R', "push telemetry", tlm_parser);
+
+void register_telemetry(void) {
+	register_parser(&tlmparser);
+	gate_task_register(&tlm_task);
+}
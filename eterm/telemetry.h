@@ -0,0 +1,98 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** eTerm push telemetry
+ * @file telemetry.h
+ *
+ * With 'R' a host subscribes to data sources, then a scheduled task
+ * sends frames at the given period without further requests. Frames
+ * are SLIP framed with CRC like binmode.h replies; response text never
+ * contains 0xC0, so a host tells frames from text by the END bytes.
+ * No frames are sent in binary mode.
+ *
+ * Command: R [Aaa] [Ppp] [Sssss] [M] [T] [D] [,ms]
+ *   - Aaa   -- ADC channels (hex mask)
+ *   - Ppp   -- port PIN values (hex mask of port numbers, see ports_i2c.h)
+ *   - Sssss -- servo positions, servos 0..15 (hex mask)
+ *   - M     -- motors PWM and direction
+ *   - T     -- stats: skipped frames, idle time
+ *   - D     -- delta frames
+ *   - ,ms   -- period, ms; without it one full frame is sent at once
+ *
+ * Answer "R=len,ms", len -- full frame bytes (SLIP framing aside).
+ * "R" alone stops: "R=0,0".
+ *
+ * Frame: [type] [seq] [...] [crc16 lo] [crc16 hi]
+ *   - TLM_FULL:  [A mask] [P mask] [S mask lo] [S mask hi] [flags] [fields]
+ *   - TLM_DELTA: [changed bitmap] [changed fields]
+ *
+ * Fields, in order: ADC results (u16), ports PIN (u8), servo positions
+ * (u16, usec), motors (PWM 0, PWM 1, directions: bit per motor; u8
+ * each), stats (skipped frames u16, idle per mille u16, 0xffff without
+ * GATE_SCHED_STATS). u16 are little endian.
+ *
+ * Bit i of the bitmap (byte i/8, LSB first) is set if field i changed
+ * since the previous frame. Every TLM_KEYFRAME-th frame is full, so is
+ * the first one. A frame is skipped and counted while the serial
+ * transmitter still has data queued; seq counts sent frames only, so
+ * a gap in seq means a lost frame.
+ *
+ * Frame rate vs baud rate (8N1: baud/10 byte/s; frame length includes
+ * two END bytes, escapes aside), e.g. "A0F P07 S00FF M":
+ *   - full frame 41 bytes: 115200 baud -- up to 280 fps (50 fps take
+ *     18% of the link), 57600 -- 140 fps, 9600 -- 23 fps
+ *   - delta frame without changes 9 bytes, with 4 ADC channels
+ *     changed 17 bytes: 115200 -- 670 fps, 9600 -- 56 fps
+ * Responses to commands share the link; leave them room.
+ *
+ * eterm/tlmdecode.c decodes frames on the host.
+ */
+
+#ifndef ETERM_TELEMETRY_H
+#define ETERM_TELEMETRY_H
+
+#define TLM_FULL          0xF0
+#define TLM_DELTA         0xF1
+
+#define TLM_FLAG_MOTOR    0x01
+#define TLM_FLAG_STATS    0x02
+
+/// Servos 0..TLM_SERVO_LEN-1 can be sent
+#define TLM_SERVO_LEN     16
+
+/// Max fields: ADC, ports, servos, motors, stats
+#define TLM_FIELDS        (8 + 8 + TLM_SERVO_LEN + 3 + 2)
+
+/// Max bytes of fields
+#define TLM_VALUES_LEN    (8 * 2 + 8 + TLM_SERVO_LEN * 2 + 3 + 2 * 2)
+
+/// Full frame period in delta mode
+#ifndef TLM_KEYFRAME
+#define TLM_KEYFRAME      16
+#endif
+
+/** register 'R' command and telemetry task
+ */
+void register_telemetry(void);
+
+#endif // ETERM_TELEMETRY_H
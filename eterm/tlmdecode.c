@@ -0,0 +1,219 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Host decoder of eTerm output with telemetry frames
+ * @file tlmdecode.c
+ *
+ * Reads eTerm output on stdin, writes text lines as they are (without
+ * '\r') and one line per SLIP frame:
+ *   - "R F #seq A0=512 P1=04 S0=1500 M=10,20,1 T=0,950" -- full frame
+ *   - "R D #seq ..." -- delta frame, all fields after applying it
+ *   - "R lost #seq" -- delta frame after a gap, skipped to next full one
+ *   - "F xx xx ..." -- other frames (binary mode replies), CRC stripped
+ *   - "R bad ..." -- CRC error or malformed frame
+ *
+ * Built with `make -C eterm tlmdecode`, used by `make sim_test`.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "binmode.h"
+#include "telemetry.h"
+#include "lib/crc16.h"
+
+#define FRAME_LEN 256
+
+static uint8_t amask, pmask, flags;
+static uint16_t smask;
+static bool have_layout;
+static uint8_t last_seq;
+
+static uint8_t nfields;
+static uint8_t field_len[TLM_FIELDS];
+static uint16_t field[TLM_FIELDS];
+
+static void layout(void) {
+	nfields = 0;
+	for (int i = 0; i < 8; i++)
+		if (amask & (1 << i))
+			field_len[nfields++] = 2;
+	for (int i = 0; i < 8; i++)
+		if (pmask & (1 << i))
+			field_len[nfields++] = 1;
+	for (int i = 0; i < TLM_SERVO_LEN; i++)
+		if (smask & (1 << i))
+			field_len[nfields++] = 2;
+	if (flags & TLM_FLAG_MOTOR)
+		for (int i = 0; i < 3; i++)
+			field_len[nfields++] = 1;
+	if (flags & TLM_FLAG_STATS)
+		for (int i = 0; i < 2; i++)
+			field_len[nfields++] = 2;
+}
+
+/** Read field i from p
+ * @return bytes used
+ */
+static int get_field(int i, const uint8_t *p) {
+	field[i] = (field_len[i] == 2) ? p[0] | (p[1] << 8) : p[0];
+	return field_len[i];
+}
+
+static void print_fields(char kind, uint8_t seq) {
+	int n = 0;
+
+	printf("R %c #%u", kind, seq);
+	for (int i = 0; i < 8; i++)
+		if (amask & (1 << i))
+			printf(" A%d=%u", i, field[n++]);
+	for (int i = 0; i < 8; i++)
+		if (pmask & (1 << i))
+			printf(" P%d=%02X", i, field[n++]);
+	for (int i = 0; i < TLM_SERVO_LEN; i++)
+		if (smask & (1 << i))
+			printf(" S%d=%u", i, field[n++]);
+	if (flags & TLM_FLAG_MOTOR) {
+		printf(" M=%u,%u,%u", field[n], field[n + 1], field[n + 2]);
+		n += 3;
+	}
+	if (flags & TLM_FLAG_STATS)
+		printf(" T=%u,%u", field[n], field[n + 1]);
+	putchar('\n');
+}
+
+static bool decode_full(const uint8_t *p, int len) {
+	int pos = 5;
+
+	if (len < 5)
+		return false;
+
+	amask = p[0];
+	pmask = p[1];
+	smask = p[2] | (p[3] << 8);
+	flags = p[4];
+	layout();
+
+	for (int i = 0; i < nfields; i++) {
+		if (pos + field_len[i] > len)
+			return false;
+		pos += get_field(i, p + pos);
+	}
+	return pos == len;
+}
+
+static bool decode_delta(const uint8_t *p, int len) {
+	int nbits = (nfields + 7) / 8;
+	int pos = nbits;
+
+	if (len < nbits)
+		return false;
+
+	for (int i = 0; i < nfields; i++) {
+		if (!(p[i / 8] & (1 << (i % 8))))
+			continue;
+		if (pos + field_len[i] > len)
+			return false;
+		pos += get_field(i, p + pos);
+	}
+	return pos == len;
+}
+
+static void frame_done(const uint8_t *f, int len) {
+	uint16_t crc = CRC16_INIT;
+
+	for (int i = 0; i < len; i++)
+		crc = crc16_update(crc, f[i]);
+	if (len < 3 || crc != 0) {
+		printf("R bad crc (%d bytes)\n", len);
+		return;
+	}
+	len -= 2;
+
+	if (f[0] == TLM_FULL && len >= 2) {
+		have_layout = decode_full(f + 2, len - 2);
+		last_seq = f[1];
+		if (have_layout)
+			print_fields('F', f[1]);
+		else
+			printf("R bad full frame #%u\n", f[1]);
+	} else if (f[0] == TLM_DELTA && len >= 2) {
+		if (!have_layout || f[1] != (uint8_t) (last_seq + 1)) {
+			have_layout = false;
+			printf("R lost #%u\n", f[1]);
+			return;
+		}
+		last_seq = f[1];
+		if (decode_delta(f + 2, len - 2)) {
+			print_fields('D', f[1]);
+		} else {
+			have_layout = false;
+			printf("R bad delta frame #%u\n", f[1]);
+		}
+	} else {
+		printf("F");
+		for (int i = 0; i < len; i++)
+			printf(" %02x", f[i]);
+		putchar('\n');
+	}
+}
+
+int main(void) {
+	static uint8_t frame[FRAME_LEN];
+	int len = 0;
+	bool in_frame = false, esc = false;
+	int c;
+
+	while ((c = getchar()) != EOF) {
+		if (c == SLIP_END) {
+			if (in_frame && len)
+				frame_done(frame, len);
+			// END ends a frame, or starts one after text
+			in_frame = !(in_frame && len);
+			len = 0;
+			esc = false;
+			continue;
+		}
+
+		if (!in_frame) {
+			if (c != '\r')
+				putchar(c);
+			continue;
+		}
+
+		if (c == SLIP_ESC) {
+			esc = true;
+			continue;
+		}
+		if (esc) {
+			esc = false;
+			c = (c == SLIP_ESC_END) ? SLIP_END : (c == SLIP_ESC_ESC) ? SLIP_ESC : c;
+		}
+		if (len < FRAME_LEN)
+			frame[len++] = c;
+	}
+
+	return 0;
+}
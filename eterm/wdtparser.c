@@ -7,6 +7,7 @@
 #include <avr/io.h>
 #include "core/wdt_ext.h"
 #include "eterm.h"
+#include "lib/fmt.h"
 
 
 void proceed_w_command(char command, uint16_t timeout) {
@@ -16,7 +17,7 @@ void proceed_w_command(char command, uint16_t timeout) {
 		case 'N':	// disable connect-watchdog
 			{
 				wdt_disable_extc();
-				printf("W=N\n");
+				fmt_str_P(PSTR("W=N\n"));
 			} break;
 
 		case 'R':	// enable connect-watchdog
@@ -62,7 +63,9 @@ void proceed_w_command(char command, uint16_t timeout) {
 				}
 
 				wdt_enable_extc(wdp_code);
-				printf("W=R,%i\n", real_timeout);
+				fmt_str_P(PSTR("W=R,"));
+				fmt_u16(real_timeout);
+				putchar('\n');
 			}
 	}
 }
@@ -107,7 +110,7 @@ static bool w_parser(char c, bool reinit) {
 					return false;
 
 				default:
-					printf("W Error. No '='\n");
+					fmt_str_P(PSTR("W Error. No '='\n"));
 					return true;
 			} break;
 
@@ -132,7 +135,7 @@ static bool w_parser(char c, bool reinit) {
 					return false;
 
 				default:
-					printf("W Error. Unknown command\n");
+					fmt_str_P(PSTR("W Error. Unknown command\n"));
 					return true;
 			} break;
 
@@ -147,7 +150,7 @@ static bool w_parser(char c, bool reinit) {
 					return false;
 
 				default:
-					printf("W Error. Invalid format\n");
+					fmt_str_P(PSTR("W Error. Invalid format\n"));
 					return true;
 			} break;
 
@@ -171,7 +174,7 @@ static bool w_parser(char c, bool reinit) {
 					return false;
 
 				default:
-					printf("W Error. Invalid timeout\n");
+					fmt_str_P(PSTR("W Error. Invalid timeout\n"));
 					return true;
 			} break;
 
@@ -199,7 +202,7 @@ static bool w_parser(char c, bool reinit) {
 					return true;
 
 				default:
-					printf("W Error. Invalid timeout\n");
+					fmt_str_P(PSTR("W Error. Invalid timeout\n"));
 					return true;
 			} break;
 
@@ -213,7 +216,7 @@ static bool w_parser(char c, bool reinit) {
 					return true;
 
 				default:
-					printf("W Error. Invalid format\n");
+					fmt_str_P(PSTR("W Error. Invalid format\n"));
 					return true;
 			} break;
 
@@ -235,7 +238,7 @@ static bool w_parser(char c, bool reinit) {
 static bool n_parser(char c, bool reinit) {
 	if (c == '\n') {
 		wdt_reset_extc();
-		puts("N");
+		fmt_str_P(PSTR("N\n"));
 		return true;
 	}
 	return false;
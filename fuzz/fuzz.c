@@ -0,0 +1,550 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** eTerm parser fuzzer and throughput benchmark
+ * @file fuzz/fuzz.c
+ *
+ * Built instead of main.c by `make fuzz` and `make parser_bench`
+ * (PLATFORM=HOST_SIM, see fuzz/resolve.mk). main.c is included, so the
+ * firmware with the simulated HALs is linked in and initialised as
+ * usual, but the scheduler loop is not started: each input line goes
+ * to parse_command(), then the harness does what eterm_supertask()
+ * and i2c_slave_task() do between commands. Interrupts stay off, so
+ * a run only depends on its input.
+ *
+ * -f seconds [seed files...]: coverage-guided fuzzing. eTerm and
+ * adapter code is built with -fsanitize-coverage=trace-pc; the edges
+ * a line takes are hashed into a map, AFL style, and lines that reach
+ * new edges (or new hit counts) are kept and mutated further. ASan and
+ * UBSan abort on bad accesses; a line that runs longer than
+ * FUZZ_HANG_MS, or leaves its command unfinished, is a finding too.
+ * The last FUZZ_LOG lines are then written to fuzz/crash.txt, the
+ * offending one last.
+ *
+ * -r file: feed the lines of file one by one, with the same checks,
+ * responses on stdout.
+ *
+ * -b: characters per second through each parser, on typical lines.
+ * Responses go to /dev/null through the simulated serial port, one
+ * write() per char, so lines with long responses mostly measure that.
+ */
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#define main firmware_main
+#include "main.c"
+#undef main
+
+#include "eterm/eterm.h"
+#include "eterm/binmode.h"
+#include "core/wdt_ext.h"
+
+#ifdef __SANITIZE_ADDRESS__
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+bool serialgate_queue_run(void);
+#ifdef ETERM_MACROS
+bool macro_run(void);
+#else
+#define macro_run() false
+#endif
+
+#define FUZZ_LINE     128   ///< max input line
+#define FUZZ_CORPUS   4096  ///< max kept lines
+#define FUZZ_LOG      16    ///< lines written on a finding
+#define FUZZ_HANG_MS  1000
+#define FUZZ_MAP      65536 ///< edge map size (power of 2)
+
+#define CRASH_FILE    "fuzz/crash.txt"
+
+#define BENCH_TIME    0.2   ///< seconds per bench line
+
+typedef struct {
+	uint8_t len;
+	char data[FUZZ_LINE];
+} LINE;
+
+// -- coverage --
+
+static uint8_t hits[FUZZ_MAP];  ///< edge hit counts of current line
+static uint8_t seen[FUZZ_MAP];  ///< hit count classes seen so far
+static uint16_t touched[FUZZ_MAP]; ///< edges hit by current line
+static unsigned num_touched;
+static unsigned num_seen;       ///< edges seen so far
+static uintptr_t prev_loc;
+
+/** Called on every edge of instrumented code
+ */
+void __sanitizer_cov_trace_pc(void)
+{
+	// offset in the image: same edges in every run, whatever ASLR does
+	uintptr_t loc = (uintptr_t) __builtin_return_address(0)
+		- (uintptr_t) __sanitizer_cov_trace_pc;
+	uint16_t edge;
+
+	loc = (loc ^ (loc >> 12)) & (FUZZ_MAP - 1);
+	edge = loc ^ prev_loc;
+	prev_loc = loc >> 1;
+
+	if (!hits[edge]++)
+		touched[num_touched++] = edge;
+	else if (!hits[edge])
+		hits[edge] = 0xff; // saturate
+}
+
+/** Hit count class bit, counts that differ a little are the same
+ */
+static uint8_t hit_class(uint8_t n)
+{
+	if (n < 4)
+		return n == 3 ? 0x04 : n;
+	if (n < 8)
+		return 0x08;
+	if (n < 16)
+		return 0x10;
+	if (n < 32)
+		return 0x20;
+	if (n < 128)
+		return 0x40;
+	return 0x80;
+}
+
+/** Merge hits of the last line into seen, clear them
+ * @return number of new edges or classes
+ */
+static unsigned merge_hits(void)
+{
+	unsigned n = 0;
+
+	for (unsigned i=0; i < num_touched; i++) {
+		uint16_t e = touched[i];
+		uint8_t c = hit_class(hits[e]);
+
+		if (!(seen[e] & c)) {
+			num_seen += !seen[e];
+			seen[e] |= c;
+			n++;
+		}
+		hits[e] = 0;
+	}
+	num_touched = 0;
+	prev_loc = 0;
+	return n;
+}
+
+// -- running lines --
+
+static LINE line_log[FUZZ_LOG];
+static unsigned line_count;
+static const char *finding;
+static unsigned hang_ms = FUZZ_HANG_MS; ///< 0 -- no hang check
+
+/** Write logged lines to CRASH_FILE (async-signal-safe)
+ */
+static void dump_log(void)
+{
+	int fd = open(CRASH_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	unsigned i = line_count > FUZZ_LOG ? line_count - FUZZ_LOG : 0;
+
+	for (; fd >= 0 && i < line_count; i++) {
+		LINE *l = &line_log[i % FUZZ_LOG];
+		if (write(fd, l->data, l->len) < 0 || write(fd, "\n", 1) < 0)
+			break;
+	}
+	if (fd >= 0)
+		close(fd);
+}
+
+static void die(const char *what)
+{
+	if (write(STDERR_FILENO, what, strlen(what)) < 0 ||
+		write(STDERR_FILENO, ", lines in " CRASH_FILE "\n",
+			sizeof(", lines in " CRASH_FILE "\n") - 1) < 0)
+	{
+		// nothing to do
+	}
+	dump_log();
+	_exit(EXIT_FAILURE);
+}
+
+static void sanitizer_death(void)
+{
+	die("sanitizer error");
+}
+
+static void abort_handler(int sig)
+{
+	(void)sig;
+	sanitizer_death();
+}
+
+static void hang_handler(int sig)
+{
+	(void)sig;
+	die("hang");
+}
+
+static void set_hang_timer(unsigned ms)
+{
+	struct itimerval it = {
+		.it_value = { ms / 1000, (ms % 1000) * 1000 },
+	};
+	setitimer(ITIMER_REAL, &it, NULL);
+}
+
+/** Feed one line (and a '\n') as the serial gate would
+ * @return false on finding
+ */
+static bool run_line(const char *s, uint8_t len)
+{
+	LINE *l = &line_log[line_count++ % FUZZ_LOG];
+
+	l->len = len;
+	memcpy(l->data, s, len);
+
+	if (hang_ms)
+		set_hang_timer(hang_ms);
+
+	for (uint8_t i=0; i <= len; i++) {
+		uint8_t c = i < len ? s[i] : '\n';
+
+		if (binmode_active) {
+			binmode_parse(c);
+		} else if (parse_command(c, false)) {
+			while (macro_run());
+		}
+	}
+
+	finding = NULL;
+	if (!binmode_active && !parse_idle())
+		finding = "command not ended by its line";
+
+	// between commands
+	while (serialgate_queue_run());
+	i2c_slave_task();
+	wdt_reset_ext();
+
+	if (hang_ms)
+		set_hang_timer(0);
+
+#ifdef ETERM_BINMODE
+	// keep ASCII parsers fed
+	binmode_active = false;
+#endif
+	return !finding;
+}
+
+// -- fuzzing --
+
+static const char *const seeds[] = {
+	"V", "VO", "X", "L", "LA0", "L00", "C", "C0064",
+	"S 00 13 S 01 02", "@01 S 00 13 S 01 02", "S 00 01 00 05 DC",
+	"S 00 13 R 02",
+	"#0P1500", "#1P2000S100T500", "#0P1000#1P2000T100", "Q", "QP0",
+	"DrvLR 10,-20", "DrvLR 100,100", "D",
+	"PMB2=O", "PSB2=1", "PGB2", "A", "W", "N",
+	"MWA:V;PSB2=1", "MXA", "ML", "MDA", "MTA,10", "MEA,B2,R", "MC",
+	"RA00P02S0001M,100", "R", "B", "%", "?",
+};
+
+static const char *const tokens[] = {
+	"@01 ", "S ", " R ", " 00", " 01", " 13", " FF", "P", "#", "T", "Q",
+	"DrvLR", "=", ",", "-", ":", ";", "B2", "MW", "MX", "1500",
+	"65535", "65536", "99999", "255", "100", "\n",
+};
+
+static const char chars[] = "0123456789ABCDEFabcdef #@%,:;=-_\nPSTRLMXDQWNVCB";
+
+static LINE corpus[FUZZ_CORPUS];
+static unsigned corpus_len;
+
+static uint32_t rnd_state = 1;
+
+static uint32_t rnd(void)
+{
+	// xorshift32
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return rnd_state;
+}
+
+static void insert(LINE *l, uint8_t pos, const char *s, uint8_t n)
+{
+	if (n > FUZZ_LINE - l->len)
+		n = FUZZ_LINE - l->len;
+	memmove(l->data + pos + n, l->data + pos, l->len - pos);
+	memcpy(l->data + pos, s, n);
+	l->len += n;
+}
+
+/** Apply a few random edits
+ */
+static void mutate(LINE *l)
+{
+	for (uint8_t n = 1 + rnd() % 4; n; n--) {
+		uint8_t pos = l->len ? rnd() % (l->len + 1) : 0;
+		uint8_t span = 1 + rnd() % 8;
+		char c;
+
+		switch (rnd() % 8) {
+		case 0: // replace char
+			if (pos < l->len)
+				l->data[pos] = chars[rnd() % (sizeof(chars) - 1)];
+			break;
+		case 1: // insert char
+			c = chars[rnd() % (sizeof(chars) - 1)];
+			insert(l, pos, &c, 1);
+			break;
+		case 2: // any byte
+			c = rnd();
+			if (pos < l->len)
+				l->data[pos] = c;
+			else
+				insert(l, pos, &c, 1);
+			break;
+		case 3: // delete span
+			if (pos + span > l->len)
+				span = l->len - pos;
+			memmove(l->data + pos, l->data + pos + span,
+					l->len - pos - span);
+			l->len -= span;
+			break;
+		case 4: // insert token
+		case 5: {
+			const char *t = tokens[rnd() % ARRAY_SIZE(tokens)];
+			insert(l, pos, t, strlen(t));
+			break;
+		}
+		case 6: // repeat span, long numbers and lists
+			if (pos + span <= l->len) {
+				char tmp[8];
+				memcpy(tmp, l->data + pos, span);
+				insert(l, pos, tmp, span);
+			}
+			break;
+		default: { // splice with another line
+			LINE *o = &corpus[rnd() % corpus_len];
+			uint8_t from = o->len ? rnd() % o->len : 0;
+			l->len = pos;
+			insert(l, pos, o->data + from, o->len - from);
+			break;
+		}
+		}
+	}
+}
+
+/** Run line, keep it if it reached new code
+ * @return false on finding
+ */
+static bool try_line(LINE *l)
+{
+	bool ok = run_line(l->data, l->len);
+
+	if (merge_hits() && corpus_len < FUZZ_CORPUS)
+		corpus[corpus_len++] = *l;
+	return ok;
+}
+
+static bool seed_line(const char *s, size_t n)
+{
+	LINE l;
+
+	l.len = n < FUZZ_LINE ? n : FUZZ_LINE;
+	memcpy(l.data, s, l.len);
+	return try_line(&l);
+}
+
+static bool seed_file(const char *path)
+{
+	char buf[256];
+	FILE *f = fopen(path, "r");
+	bool ok = true;
+
+	if (!f) {
+		perror(path);
+		return true;
+	}
+	while (ok && fgets(buf, sizeof(buf), f))
+		ok = seed_line(buf, strcspn(buf, "\n"));
+	fclose(f);
+	return ok;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int fuzz(FILE *out, double seconds, int nfiles, char **files)
+{
+	unsigned long execs = 0;
+	double start = now(), t, report = start + 10;
+	LINE l;
+
+	for (unsigned i=0; i < ARRAY_SIZE(seeds); i++)
+		if (!seed_line(seeds[i], strlen(seeds[i])))
+			goto found;
+	for (int i=0; i < nfiles; i++)
+		if (!seed_file(files[i]))
+			goto found;
+
+	fprintf(out, "fuzz: %u seed lines, %u edges\n", corpus_len, num_seen);
+
+	while ((t = now()) < start + seconds) {
+		for (unsigned i=0; i < 1000; i++) {
+			l = corpus[rnd() % corpus_len];
+			mutate(&l);
+			if (!try_line(&l))
+				goto found;
+		}
+		execs += 1000;
+
+		if (t >= report) {
+			fprintf(out, "fuzz: %.0fs %lu lines, %u kept, %u edges\n",
+					t - start, execs, corpus_len, num_seen);
+			fflush(out);
+			report += 10;
+		}
+	}
+
+	t = now() - start;
+	fprintf(out, "fuzz: %lu lines in %.0fs (%.0f/s), %u kept, %u edges, "
+			"no findings\n", execs, t, execs / t, corpus_len, num_seen);
+	return EXIT_SUCCESS;
+
+found:
+	die(finding);
+	return EXIT_FAILURE;
+}
+
+// -- replay --
+
+static int replay(const char *path)
+{
+	char buf[256];
+	FILE *f = fopen(path, "r");
+
+	if (!f) {
+		perror(path);
+		return EXIT_FAILURE;
+	}
+	while (fgets(buf, sizeof(buf), f)) {
+		size_t n = strcspn(buf, "\n");
+		if (!run_line(buf, n < FUZZ_LINE ? n : FUZZ_LINE))
+			die(finding);
+	}
+	fclose(f);
+	return EXIT_SUCCESS;
+}
+
+// -- throughput --
+
+typedef struct {
+	const char *parser;
+	const char *line;
+} BENCH_LINE;
+
+static const BENCH_LINE bench_lines[] = {
+	{ "comment", "% a comment line to skip" },
+	{ "version", "V" },
+	{ "local", "LA0" },
+	{ "speed", "C0064" },
+	{ "i2c write", "S 00 01 00 05 DC" },
+	{ "i2c read", "S 00 13 S 01 02" },
+	{ "i2c rep read", "S 00 13 R 02" },
+	{ "i2c tagged", "@01 S 00 13 S 01 02" },
+	{ "servo move", "#0P1500#1P2000S100T500" },
+	{ "servo query", "QP0" },
+	{ "drive", "DrvLR 10,-20" },
+	{ "pin", "PSB2=1" },
+	{ "unknown", "Z" },
+};
+
+static int bench(FILE *out)
+{
+	hang_ms = 0;
+
+	for (unsigned i=0; i < ARRAY_SIZE(bench_lines); i++) {
+		const BENCH_LINE *b = &bench_lines[i];
+		uint8_t len = strlen(b->line);
+		unsigned long n = 0;
+		double start = now(), t;
+
+		do {
+			for (unsigned k=0; k < 1000; k++)
+				run_line(b->line, len);
+			n += 1000;
+		} while ((t = now() - start) < BENCH_TIME);
+
+		fprintf(out, "%-12s %-24s %6.2f M chars/s\n", b->parser, b->line,
+				n * (len + 1) / t * 1e-6);
+	}
+	return EXIT_SUCCESS;
+}
+
+static int usage(const char *name)
+{
+	fprintf(stderr, "usage: %s -f seconds [seed files...] | -r file | -b\n",
+			name);
+	return EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[])
+{
+	FILE *out;
+
+#ifdef __SANITIZE_ADDRESS__
+	// UBSan reads options at start only, and _exit()s by default
+	if (!getenv("UBSAN_OPTIONS")) {
+		setenv("UBSAN_OPTIONS", "print_stacktrace=1:abort_on_error=1", 1);
+		execv("/proc/self/exe", argv);
+	}
+	__sanitizer_set_death_callback(sanitizer_death);
+#endif
+	signal(SIGALRM, hang_handler);
+	signal(SIGABRT, abort_handler);
+
+	if (argc >= 3 && !strcmp(argv[1], "-r"))
+		return replay(argv[2]);
+
+	// firmware responses are not interesting here
+	out = fdopen(dup(STDOUT_FILENO), "w");
+	dup2(open("/dev/null", O_WRONLY), STDOUT_FILENO);
+
+	if (argc >= 3 && !strcmp(argv[1], "-f"))
+		return fuzz(out, atof(argv[2]), argc - 3, argv + 3);
+	if (argc == 2 && !strcmp(argv[1], "-b"))
+		return bench(out);
+	return usage(argv[0]);
+}
@@ -0,0 +1,25 @@
+# -*- Makefile -*-
+# Parser fuzzer image (FUZZ=yes, see `make fuzz` in debug.mk):
+# fuzz/fuzz.c replaces main.c, everything else is the usual HOST_SIM
+# firmware. eTerm and adapter objects report their coverage to the
+# fuzzer, and everything is built with ASan and UBSan.
+# FUZZ_SAN=no builds it plain, for `make parser_bench`.
+
+ifneq ($(PLATFORM),HOST_SIM)
+    $(error parser fuzzing runs on the host, use PLATFORM=HOST_SIM)
+endif
+
+target = ${ORFA}/fuzz/orfa_fuzz
+SRC := $(filter-out main.c,$(SRC)) ${ORFA}/fuzz/fuzz.c
+
+ifneq ($(FUZZ_SAN),no)
+SAN_FLAGS = -fsanitize=address,undefined -fno-sanitize-recover=all
+CFLAGS += $(SAN_FLAGS) -fno-omit-frame-pointer
+LDFLAGS += $(SAN_FLAGS)
+
+# code under test: eTerm parsers and the adapters they reach through
+# the local i2c slave
+FUZZ_COVERAGE_OBJS = $(ETERMLIB_OBJS) \
+	$(patsubst %.c,%.o,$(filter adapters/% ${ORFA}/adapters/%,$(SRC)))
+$(FUZZ_COVERAGE_OBJS): CFLAGS += -fsanitize-coverage=trace-pc
+endif
@@ -51,13 +51,28 @@
 #define adc_config \
 	adc_lld_config
 
-/** ADC result table
+/** ADC result table (last complete sweep)
  */
 #define adc_result \
 	adc_lld_result
 
+/** ADC result table, big endian bytes (refreshed with adc_result)
+ */
+#define adc_table \
+	adc_lld_table
+
+/** Hold result table (no updates while set)
+ */
+#define adc_hold \
+	adc_lld_hold
+
 #define adc_get_result \
 	adc_lld_get_result
+
+/** Copy last complete sweep, returns its sequence number
+ */
+#define adc_get_frame(result) \
+	adc_lld_get_frame(result)
 
 #define adc_get_mask \
 	adc_lld_get_mask
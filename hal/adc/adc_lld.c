@@ -31,8 +31,10 @@
 #include <stdint.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <util/atomic.h>
 
 #include "adc_lld.h"
+#include "core/event.h"
 
 #ifndef HAL_ADC_NISR
 #define ADC_INTERRUPT_MASK _BV(ADIE)
@@ -42,12 +44,37 @@
 
 // extern data
 ADC_VOLATILE uint8_t adc_lld_config = 0x05; // 10 bit @ AVCC
-ADC_VOLATILE uint16_t adc_lld_result[ADC_LEN];
+ADC_VOLATILE bool adc_lld_hold;
+static uint16_t adc_frames[2][ADC_LEN];
+GATE_SNAPSHOT adc_lld_snapshot = GATE_SNAPSHOT_INIT(adc_frames);
+uint8_t adc_lld_table[ADC_LEN * 2];
 // ISR data
 static ADC_VOLATILE uint8_t conversion_channel = 0xFF;
 static ADC_VOLATILE uint8_t conversion_mask;
 static ADC_VOLATILE uint8_t mask;
 
+/** Publish back frame and refresh the big endian table
+ * Does nothing while the table is held. The hold check and the table
+ * update are atomic, so a window opened from the I2C ISR never sees
+ * a half-written table.
+ */
+static void publish(void)
+{
+	const uint16_t* frame;
+	uint8_t i;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		if (!adc_lld_hold) {
+			gate_snapshot_publish(&adc_lld_snapshot);
+			frame = adc_lld_result;
+			for (i = 0; i < ADC_LEN; i++) {
+				adc_lld_table[2 * i] = frame[i] >> 8;
+				adc_lld_table[2 * i + 1] = frame[i] & 0xFF;
+			}
+		}
+	}
+}
+
 uint16_t adc_lld_get_result(uint8_t channel)
 {
 	if (channel > 7)
@@ -93,6 +120,9 @@ ISR(ADC_vect)
 void adc_lld_loop(void)
 #endif
 {
+	bool stored = false;
+	bool wrapped = false;
+
 #ifdef HAL_ADC_NISR
 	if (!(ADCSRA & _BV(ADIF)))
 		// conversion isn't done
@@ -101,12 +131,18 @@ void adc_lld_loop(void)
 	ADCSRA |= _BV(ADIF);
 #endif
 	if (conversion_channel != 0xFF) {
-		adc_lld_result[conversion_channel] = adc_lld_is_10bit()? ADC : ADCH;
+		uint16_t* frame = gate_snapshot_back(&adc_lld_snapshot);
+		frame[conversion_channel] = adc_lld_is_10bit()? ADC : ADCH;
+		stored = true;
+#ifndef HAL_ADC_NISR
+		gate_event_post_isr(GATE_EVT_ADC);
+#endif
 		conversion_channel++;
 		conversion_channel &= 0x07;
 		conversion_mask <<= 1;
 		if (!conversion_mask) {
 			conversion_mask = 0x01;
+			wrapped = true;
 		}
 	} else {
 		conversion_channel = 0;
@@ -123,9 +159,15 @@ void adc_lld_loop(void)
 		conversion_mask <<= 1;
 		if (!conversion_mask) {
 			conversion_mask = 0x01;
+			wrapped = true;
 		}
 	}
 
+	// sweep done -- publish frame
+	if (stored && wrapped) {
+		publish();
+	}
+
 	// set channel and run conversion
 	ADMUX = (ADMUX & ~0x07) | conversion_channel;
 	ADCSRA = _BV(ADEN) | ADC_INTERRUPT_MASK | (5 << ADPS0) | _BV(ADSC);
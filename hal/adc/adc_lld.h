@@ -34,6 +34,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "core/snapshot.h"
+
 #ifndef HAL_ADC_NISR
 #define ADC_VOLATILE volatile
 #else
@@ -56,9 +58,29 @@
  */
 extern ADC_VOLATILE uint8_t adc_lld_config;
 
-/** ADC result table
+/** ADC result frames
+ * Each frame is uint16_t[ADC_LEN], published after a full sweep of
+ * enabled channels.
+ */
+extern GATE_SNAPSHOT adc_lld_snapshot;
+
+/** ADC result table (last published sweep)
+ */
+#define adc_lld_result \
+	((const uint16_t*) gate_snapshot_front(&adc_lld_snapshot))
+
+/** ADC result table in bus byte order
+ * ADC_LEN x u16, big endian (MSB first, as the I2C registers send
+ * values). Refreshed together with adc_lld_result when a sweep is
+ * published, so it stays unchanged while adc_lld_hold is set.
  */
-extern ADC_VOLATILE uint16_t adc_lld_result[ADC_LEN];
+extern uint8_t adc_lld_table[ADC_LEN * 2];
+
+/** Hold result table
+ * While set, finished sweeps are not published and adc_lld_result
+ * stays unchanged.
+ */
+extern ADC_VOLATILE bool adc_lld_hold;
 
 #define adc_lld_is_10bit() \
 	(adc_lld_config & 0x04)
@@ -76,6 +98,13 @@ uint8_t adc_lld_get_mask(void);
 
 uint16_t adc_lld_get_result(uint8_t channel);
 
+/** Copy last published sweep
+ * @param[out] result table of ADC_LEN values
+ * @return frame sequence number
+ */
+#define adc_lld_get_frame(result) \
+	gate_snapshot_read(&adc_lld_snapshot, result)
+
 #if defined(HAL_ADC_NISR) || defined(__DOXYGEN__)
 /** ADC periodic
  */
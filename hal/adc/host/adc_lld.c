@@ -0,0 +1,111 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** ADC for the host simulation
+ * @file adc/host/adc_lld.c
+ *
+ * Conversions finish at once (polled mode, HAL_ADC_NISR). Inputs are
+ * taken from ORFA_SIM_ADC, a comma separated list of 10-bit values.
+ */
+
+#include <stdlib.h>
+#include <util/atomic.h>
+
+#include "adc_lld.h"
+
+// extern data
+uint8_t adc_lld_config = 0x05; // 10 bit @ AVCC
+bool adc_lld_hold;
+static uint16_t adc_frames[2][ADC_LEN];
+GATE_SNAPSHOT adc_lld_snapshot = GATE_SNAPSHOT_INIT(adc_frames);
+uint8_t adc_lld_table[ADC_LEN * 2];
+
+static uint16_t input[ADC_LEN];
+static uint8_t mask;
+
+/** Publish back frame and refresh the big endian table
+ * Does nothing while the table is held. The hold check and the table
+ * update are atomic, so a window opened from the I2C ISR never sees
+ * a half-written table.
+ */
+static void publish(void)
+{
+	const uint16_t* frame;
+	uint8_t i;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		if (!adc_lld_hold) {
+			gate_snapshot_publish(&adc_lld_snapshot);
+			frame = adc_lld_result;
+			for (i = 0; i < ADC_LEN; i++) {
+				adc_lld_table[2 * i] = frame[i] >> 8;
+				adc_lld_table[2 * i + 1] = frame[i] & 0xFF;
+			}
+		}
+	}
+}
+
+uint16_t adc_lld_get_result(uint8_t channel)
+{
+	if (channel > 7)
+		return 0;
+	return adc_lld_result[channel];
+}
+
+uint8_t adc_lld_get_mask(void)
+{
+	return mask;
+}
+
+void adc_lld_reconfigure(uint8_t new_mask)
+{
+	const char* env = getenv("ORFA_SIM_ADC");
+	uint8_t i;
+
+	for (i = 0; env && *env && i < ADC_LEN; i++) {
+		char* end;
+		input[i] = strtoul(env, &end, 0) & 0x3FF;
+		env = (*end == ',') ? end + 1 : end;
+	}
+
+	mask = new_mask;
+}
+
+void adc_lld_loop(void)
+{
+	uint16_t* frame = gate_snapshot_back(&adc_lld_snapshot);
+	uint8_t i;
+
+	if (!mask) {
+		return;
+	}
+
+	// one full sweep per call
+	for (i = 0; i < ADC_LEN; i++) {
+		if (mask & (1 << i)) {
+			frame[i] = adc_lld_is_10bit() ? input[i] : input[i] >> 2;
+		}
+	}
+
+	publish();
+}
@@ -3,6 +3,14 @@
 ifeq ($(PLATFORM),OR_AVR_M32_D)
 	DEFINES += -DHAL_ADC_NISR
 endif
+ifeq ($(PLATFORM),HOST_SIM)
+	DEFINES += -DHAL_ADC_NISR
+endif
 
 INCLUDE_DIRS += -I${ORFA}/hal/adc
-HAL_SRC += ${ORFA}/hal/adc/adc_lld.c
+
+ifeq ($(PLATFORM),HOST_SIM)
+	HAL_SRC += ${ORFA}/hal/adc/host/adc_lld.c
+else
+	HAL_SRC += ${ORFA}/hal/adc/adc_lld.c
+endif
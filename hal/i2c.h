@@ -15,10 +15,6 @@
  */
 #define i2c_set_slave_handlers  i2c_lld_set_slave_handlers
 
-/** Set I2C master rx/tx callbacks
- */
-#define i2c_set_master_handlers  i2c_lld_set_master_handlers
-
 /** Set I2C bus speed
  */
 #define i2c_set_freq  i2c_lld_set_freq
@@ -35,18 +31,44 @@
  */
 #define i2c_get_local  i2c_lld_get_local
 
-/** Start master transmission (master write)
+/** Queue master transfer (no wait)
+ */
+#define i2c_submit  i2c_lld_submit
+
+/** Wait for queued master transfer
  */
-#define i2c_start_transmission  i2c_lld_start_transmission
+#define i2c_wait  i2c_lld_wait
 
-/** Start master read
+/** Master transfer (submit and wait)
  */
-#define i2c_request  i2c_lld_request
+#define i2c_transfer  i2c_lld_transfer
+
+/** Time out stuck master transfer (periodic)
+ */
+#define i2c_check  i2c_lld_check
 
 /** Clear bus
  */
 #define i2c_clearbus i2c_lld_clearbus
 
+/** Hold back slave events (stretch the bus)
+ */
+#define i2c_lock  i2c_lld_lock
+
+/** Release slave events
+ */
+#define i2c_unlock  i2c_lld_unlock
+
+#ifdef HAL_I2C_STATS
+/** Copy bus statistics
+ */
+#define i2c_stats_read  i2c_lld_stats_read
+
+/** Reset bus statistics
+ */
+#define i2c_stats_reset  i2c_lld_stats_reset
+#endif
+
 #ifdef I2C_NO_ISR
 /** I2C controller task
  */
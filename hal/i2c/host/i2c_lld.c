@@ -0,0 +1,292 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** I2C (TWI) for the host simulation
+ * @file i2c/host/i2c_lld.c
+ *
+ * There is no external bus: master transfers to the local slave
+ * address are routed to the slave handlers, as on hardware, and all
+ * other addresses are not acknowledged.
+ *
+ * Stuck bus model: with ORFA_SIM_I2C_STUCK=n the bus starts with SDA
+ * held low by a slave that lets go after n recovery clocks (more than
+ * 9 -- never). Bus transfers wait meanwhile, until i2c_lld_check()
+ * times them out or i2c_lld_clearbus() frees the bus.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "i2c_lld.h"
+#include "core/event.h"
+#include "hal/systick.h"
+#include "host.h"
+
+static uint16_t freq_khz = 100;
+
+static i2cStartHandler startHandler = NULL;
+static i2cStopHandler stopHandler = NULL;
+
+static uint8_t slave_addr = 0;
+static i2cRxHandler slaveRxHandler = NULL;
+static i2cTxHandler slaveTxHandler = NULL;
+
+static uint8_t stuck_clocks; ///< recovery clocks until SDA is free
+static i2c_xfer_t *xfer_head; ///< waiting for the stuck bus
+static i2c_xfer_t *xfer_tail;
+static systick_t deadline;
+
+#ifdef HAL_I2C_STATS
+// no bus slave side: slave counters and times stay 0
+static i2c_stats_t stats;
+#endif
+
+void i2c_lld_set_evt_handlers(i2cStartHandler start, i2cStopHandler stop)
+{
+	startHandler = start;
+	stopHandler = stop;
+}
+
+void i2c_lld_set_slave_handlers(i2cRxHandler slave_rx, i2cTxHandler slave_tx)
+{
+	slaveRxHandler = slave_rx;
+	slaveTxHandler = slave_tx;
+}
+
+/** Serve transfer to the local address with the slave handlers
+ */
+static uint8_t route_local(i2c_xfer_t *x)
+{
+	uint8_t c;
+	bool ack;
+
+	if (x->tx_len || !x->rx_len) {
+		startHandler(false);
+		while (x->tx_count < x->tx_len) {
+			if (!slaveRxHandler(x->tx[x->tx_count])) {
+				stopHandler();
+				return I2C_E_DATA_NACK;
+			}
+			x->tx_count++;
+		}
+		stopHandler();
+	}
+	// slave sees repeated START as STOP (TW_SR_STOP), then START
+	if (x->rx_len) {
+		startHandler(true);
+		while (x->rx_count < x->rx_len) {
+			ack = x->rx_count + 1 < x->rx_len;
+			slaveTxHandler(&c, &ack);
+			x->rx[x->rx_count++] = c;
+		}
+		stopHandler();
+	}
+	return I2C_E_OK;
+}
+
+#ifdef HAL_I2C_STATS
+/** Count finished bus transfer
+ */
+static void stats_master(const i2c_xfer_t *x, uint8_t status)
+{
+	stats.m_xfers++;
+	stats.m_bytes += x->tx_count + x->rx_count;
+	switch (status) {
+		case I2C_E_ADDR_NACK:
+			stats.addr_nack++;
+			break;
+		case I2C_E_DATA_NACK:
+			stats.data_nack++;
+			break;
+		case I2C_E_ARB:
+			stats.arb_lost++;
+			break;
+		case I2C_E_TIMEOUT:
+			stats.timeouts++;
+			break;
+	}
+}
+#else
+#define stats_master(x, status)
+#endif
+
+static void xfer_done(i2c_xfer_t *x, uint8_t status)
+{
+	x->status = status;
+	gate_event_post(GATE_EVT_I2C_MASTER);
+	if (x->done) {
+		x->done(x);
+	}
+}
+
+static void head_start(void)
+{
+	deadline = systick_get() + SYSTICK_MS(I2C_TIMEOUT_MS) +
+		SYSTICK_MS(1) * (xfer_head->tx_len + xfer_head->rx_len);
+}
+
+/** Finish the head transfer
+ */
+static void head_done(uint8_t status)
+{
+	i2c_xfer_t *x = xfer_head;
+
+	xfer_head = x->next;
+	stats_master(x, status);
+	if (!xfer_head) {
+		host_busy(false);
+	} else {
+		head_start();
+	}
+	xfer_done(x, status);
+}
+
+// local transfers and free bus ones are done at once
+void i2c_lld_submit(i2c_xfer_t *xfer)
+{
+	xfer->status = I2C_E_PENDING;
+	xfer->tx_count = 0;
+	xfer->rx_count = 0;
+	xfer->next = NULL;
+
+	if (i2c_lld_get_local() == xfer->addr) {
+		// slave side done, as after STOP on the bus
+		gate_event_post(GATE_EVT_I2C);
+		xfer_done(xfer, route_local(xfer));
+	} else if (!stuck_clocks) {
+		stats_master(xfer, I2C_E_ADDR_NACK);
+		xfer_done(xfer, I2C_E_ADDR_NACK);
+	} else if (xfer_head) {
+		xfer_tail->next = xfer;
+		xfer_tail = xfer;
+	} else {
+		xfer_head = xfer_tail = xfer;
+		host_busy(true);
+		head_start();
+	}
+}
+
+static uint8_t bus_reset(uint8_t abort_status)
+{
+	if (xfer_head) {
+		head_done(abort_status);
+	}
+
+	if (stuck_clocks > 9) {
+#ifdef HAL_I2C_STATS
+		stats.bus_errors++;
+#endif
+		return I2C_E_BUS;
+	}
+
+	stuck_clocks = 0;
+	while (xfer_head) {
+		head_done(I2C_E_ADDR_NACK);
+	}
+	return I2C_E_OK;
+}
+
+uint8_t i2c_lld_clearbus(void)
+{
+	return bus_reset(I2C_E_BUS);
+}
+
+void i2c_lld_check(void)
+{
+	if (xfer_head && systick_after_eq(systick_get(), deadline)) {
+		bus_reset(I2C_E_TIMEOUT);
+	}
+}
+
+uint8_t i2c_lld_wait(i2c_xfer_t *xfer)
+{
+	while (xfer->status == I2C_E_PENDING) {
+		i2c_lld_check();
+	}
+	return xfer->status;
+}
+
+uint8_t i2c_lld_transfer(i2c_xfer_t *xfer)
+{
+	i2c_lld_submit(xfer);
+	return i2c_lld_wait(xfer);
+}
+
+void i2c_lld_set_freq(uint16_t freq)
+{
+	freq_khz = freq;
+}
+
+uint16_t i2c_lld_get_freq(void)
+{
+	return freq_khz;
+}
+
+void i2c_lld_init(void)
+{
+	const char* env = getenv("ORFA_SIM_I2C_STUCK");
+
+	i2c_lld_set_freq(100);
+	if (env) {
+		int n = atoi(env);
+		stuck_clocks = (n > 9) ? 10 : n;
+	}
+}
+
+void i2c_lld_init_slave(uint8_t addr)
+{
+	slave_addr = addr;
+	i2c_lld_init();
+}
+
+void i2c_lld_set_local(uint8_t addr)
+{
+	slave_addr = addr;
+}
+
+uint8_t i2c_lld_get_local(void)
+{
+	return slave_addr;
+}
+
+#ifdef HAL_I2C_STATS
+void i2c_lld_stats_read(i2c_stats_t *s)
+{
+	*s = stats;
+}
+
+void i2c_lld_stats_reset(void)
+{
+	memset(&stats, 0, sizeof(stats));
+}
+#endif
+
+// slave events come from local requests only, nothing to hold back
+void i2c_lld_lock(void)
+{
+}
+
+void i2c_lld_unlock(void)
+{
+}
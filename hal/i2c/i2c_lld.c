@@ -33,10 +33,14 @@
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <util/atomic.h>
 #include <util/twi.h>
+#include <util/delay.h>
 #include <stdint.h>
 #include <string.h>
 #include "i2c_lld.h"
+#include "core/event.h"
+#include "hal/systick.h"
 
 
 #define I2C_IDLE	0
@@ -44,7 +48,7 @@
 #define I2C_MRX		2
 #define I2C_STX		3
 #define I2C_SRX		4
-#define I2C_MSTART  4
+#define I2C_MSTART  5
 
 #ifndef I2C_NO_ISR
 #define TWCR_TWIE_IF_ISR  _BV(TWIE)
@@ -52,13 +56,38 @@
 #define TWCR_TWIE_IF_ISR  0
 #endif
 
+// SCL/SDA as port pins, for bus recovery
+#if defined(__AVR_ATmega128__) || defined(__AVR_ATmega64__)
+#  define I2C_PORT	PORTD
+#  define I2C_DDR	DDRD
+#  define I2C_PIN	PIND
+#  define I2C_SCL	PD0
+#  define I2C_SDA	PD1
+#elif defined(__AVR_ATmega168__) || defined(__AVR_ATmega88__) || defined(__AVR_ATmega328P__)
+#  define I2C_PORT	PORTC
+#  define I2C_DDR	DDRC
+#  define I2C_PIN	PINC
+#  define I2C_SCL	PC5
+#  define I2C_SDA	PC4
+#else // ATmega16/32
+#  define I2C_PORT	PORTC
+#  define I2C_DDR	DDRC
+#  define I2C_PIN	PINC
+#  define I2C_SCL	PC0
+#  define I2C_SDA	PC1
+#endif
+
+/// Recovery clock half period, us (100 kHz)
+#define I2C_RECOVERY_US	5
+/// Max wait for a slave stretching SCL in recovery, us
+#define I2C_STRETCH_US	1000
+
 
 #ifdef I2C_MASTER
-static uint8_t slarw;
-static uint8_t error = I2C_E_OK;
 static volatile uint8_t state = I2C_IDLE;
-static i2cTxHandler masterTxHandler;
-static i2cRxHandler masterRxHandler;
+static i2c_xfer_t *volatile xfer_head; ///< transfer on the bus
+static i2c_xfer_t *xfer_tail;
+static systick_t deadline;     ///< of the head transfer
 #endif
 
 static i2cStartHandler startHandler = NULL;
@@ -71,6 +100,11 @@ static i2cTxHandler slaveTxHandler = NULL;
 static volatile uint8_t inCallback = 0;
 #endif
 
+#ifdef HAL_I2C_STATS
+static i2c_stats_t stats;
+static uint32_t lock_start;    ///< cycles, when slave events were held back
+#endif
+
 
 void i2c_lld_set_evt_handlers(i2cStartHandler start, i2cStopHandler stop)
 {
@@ -84,12 +118,6 @@ void i2c_lld_set_slave_handlers(i2cRxHandler slave_rx, i2cTxHandler slave_tx)
 	slaveTxHandler = slave_tx;
 }
 
-void i2c_lld_set_master_handlers(i2cRxHandler master_rx, i2cTxHandler master_tx)
-{
-	masterRxHandler = master_rx;
-	masterTxHandler = master_tx;
-}
-
 
 static void reply(uint8_t ack)
 {
@@ -110,6 +138,30 @@ static void reply(uint8_t ack)
 }
 
 #ifdef I2C_MASTER
+#ifdef HAL_I2C_STATS
+/** Count finished master transfer
+ */
+static void stats_master(const i2c_xfer_t *x, uint8_t status)
+{
+	stats.m_xfers++;
+	stats.m_bytes += x->tx_count + x->rx_count;
+	switch (status) {
+		case I2C_E_ADDR_NACK:
+			stats.addr_nack++;
+			break;
+		case I2C_E_DATA_NACK:
+			stats.data_nack++;
+			break;
+		case I2C_E_ARB:
+			stats.arb_lost++;
+			break;
+		case I2C_E_TIMEOUT:
+			stats.timeouts++;
+			break;
+	}
+}
+#endif
+
 static void send_stop(void)
 {
 	TWCR = 
@@ -123,6 +175,61 @@ static void send_stop(void)
 	//while(TWCR & _BV(TWSTO));
 	state = I2C_IDLE;
 }
+
+/** Send START for the head transfer
+ * @param stop  send STOP before it (bus is ours)
+ * START waits until the bus is free.
+ */
+static void master_start(bool stop)
+{
+	deadline = systick_get() + SYSTICK_MS(I2C_TIMEOUT_MS) +
+		SYSTICK_MS(1) * (xfer_head->tx_len + xfer_head->rx_len);
+	TWCR =
+			_BV(TWINT)
+		|	_BV(TWSTA)
+		|	(stop ? _BV(TWSTO) : 0)
+		|	_BV(TWEN)
+		|	TWCR_TWIE_IF_ISR
+		;
+	state = I2C_MSTART;
+}
+
+/** Head transfer is in its read phase
+ */
+static inline bool master_reading(const i2c_xfer_t *x)
+{
+	return x->tx_count == x->tx_len && x->rx_len;
+}
+
+/** Finish the head transfer
+ * @return true if more transfers are queued
+ */
+static bool master_finish(uint8_t status)
+{
+	i2c_xfer_t *x = xfer_head;
+
+	xfer_head = x->next;
+#ifdef HAL_I2C_STATS
+	stats_master(x, status);
+#endif
+	x->status = status;
+	gate_event_post_isr(GATE_EVT_I2C_MASTER);
+	if (x->done) {
+		x->done(x);
+	}
+	return xfer_head != NULL;
+}
+
+/** Finish the head transfer, release the bus or start the next one
+ */
+static void master_done(uint8_t status)
+{
+	if (master_finish(status)) {
+		master_start(true);
+	} else {
+		send_stop();
+	}
+}
 #endif
 
 static void release(void)
@@ -139,6 +246,20 @@ static void release(void)
 #endif
 }
 
+/** Slave transfer is over: go idle, or start queued master transfers
+ */
+static void slave_done(void)
+{
+#ifdef I2C_MASTER
+	if (xfer_head) {
+		master_start(false);
+		return;
+	}
+	state = I2C_IDLE;
+#endif
+	reply(1);
+}
+
 
 #ifdef I2C_NO_ISR
 void i2c_lld_loop(void);
@@ -148,6 +269,9 @@ ISR(SIG_2WIRE_SERIAL)
 {
 	uint8_t status = TWSR & 0xF8;
     bool ack = 1;
+#ifdef HAL_I2C_STATS
+	uint32_t isr_start = systick_cycles();
+#endif
 
 	switch (status) {
 #ifdef I2C_SLAVE
@@ -157,6 +281,9 @@ ISR(SIG_2WIRE_SERIAL)
 		case TW_SR_SLA_ACK:
 #  ifdef I2C_MASTER
 			state = I2C_SRX;
+#  endif
+#  ifdef HAL_I2C_STATS
+			stats.s_xfers++;
 #  endif
             if (startHandler) {
 				reply(startHandler(0));
@@ -166,12 +293,15 @@ ISR(SIG_2WIRE_SERIAL)
 
 #  ifdef I2C_MASTER
 			if (status == TW_SR_ARB_LOST_SLA_ACK) {
-				error = I2C_E_ARB;
+				master_finish(I2C_E_ARB);
 			}
 #  endif
 			break;
 			
 		case TW_SR_DATA_ACK:
+#  ifdef HAL_I2C_STATS
+			stats.s_bytes++;
+#  endif
             if (slaveRxHandler) {
                 reply(slaveRxHandler(TWDR));
             } else {
@@ -180,6 +310,9 @@ ISR(SIG_2WIRE_SERIAL)
 			break;
 
 		case TW_SR_DATA_NACK:
+#  ifdef HAL_I2C_STATS
+			stats.s_bytes++;
+#  endif
 			reply(1);
 			break;
 
@@ -187,10 +320,8 @@ ISR(SIG_2WIRE_SERIAL)
             if (stopHandler) {
                 stopHandler();
             }
-#  ifdef I2C_MASTER
-			state = I2C_IDLE;
-#  endif
-			reply(1);
+			gate_event_post_isr(GATE_EVT_I2C);
+			slave_done();
 			break;
 
 		/*}}}*/
@@ -202,12 +333,18 @@ ISR(SIG_2WIRE_SERIAL)
 #  ifdef I2C_MASTER
 			state = I2C_STX;
 			if (status == TW_ST_ARB_LOST_SLA_ACK) {
-				error = I2C_E_ARB;
+				master_finish(I2C_E_ARB);
 			}
+#  endif
+#  ifdef HAL_I2C_STATS
+			stats.s_xfers++;
 #  endif
 			startHandler(1);
 			// fallback
 		case TW_ST_DATA_ACK:
+#  ifdef HAL_I2C_STATS
+			stats.s_bytes++;
+#  endif
             if (slaveTxHandler) {
                 uint8_t c = 0;
                 slaveTxHandler(&c, &ack);
@@ -221,11 +358,13 @@ ISR(SIG_2WIRE_SERIAL)
 
 		case TW_ST_LAST_DATA:
 		case TW_ST_DATA_NACK:
-			reply(1);
-
-#  ifdef I2C_MASTER
-			state = I2C_IDLE;
-#  endif
+			// no TW_SR_STOP follows: the transaction ends here, the
+			// read window must be released
+			if (stopHandler) {
+				stopHandler();
+			}
+			gate_event_post_isr(GATE_EVT_I2C);
+			slave_done();
 			break;
 		/*}}}*/
 #endif // I2C_SLAVE
@@ -233,55 +372,63 @@ ISR(SIG_2WIRE_SERIAL)
 #ifdef I2C_MASTER
 		// master transmitter
 		/*{{{*/
-		case TW_MT_SLA_ACK:
 		case TW_MT_DATA_ACK:
-            if (masterTxHandler) {
-                uint8_t c;
-                ack = masterTxHandler(&c, &ack);
-                if (ack) {
-    				TWDR = c;
-				    reply(1);
-                    state = I2C_MTX;
-                } else {
-				    send_stop();
-                }
+			xfer_head->tx_count++;
+			// fallback
+		case TW_MT_SLA_ACK: {
+			i2c_xfer_t *x = xfer_head;
+			if (x->tx_count < x->tx_len) {
+				TWDR = x->tx[x->tx_count];
+				reply(1);
+				state = I2C_MTX;
+			} else if (x->rx_len) {
+				// read phase: repeated START, the bus stays ours
+				TWCR =
+						_BV(TWINT)
+					|	_BV(TWSTA)
+					|	_BV(TWEN)
+					|	TWCR_TWIE_IF_ISR
+					;
+				state = I2C_MSTART;
 			} else {
-				send_stop();
+				master_done(I2C_E_OK);
 			}
 			break;
+		}
 
 		case TW_MT_SLA_NACK:
-			error = I2C_E_ADDR_NACK;
-			send_stop();
+			master_done(I2C_E_ADDR_NACK);
 			break;
 		case TW_MT_DATA_NACK:
-			error = I2C_E_DATA_NACK;
-			send_stop();
+			master_done(I2C_E_DATA_NACK);
 			break;
 
 		case TW_MT_ARB_LOST:
-			error = I2C_E_ARB;
-			release();
+			// the bus is not ours, next START waits for it
+			if (master_finish(I2C_E_ARB)) {
+				master_start(false);
+			} else {
+				release();
+			}
 			break;
 		/*}}}*/
 
 		//  master receiver
 		/*{{{*/
 		case TW_MR_DATA_ACK:
-            if (masterRxHandler) {
-                ack = masterRxHandler(TWDR);
-            }
+			xfer_head->rx[xfer_head->rx_count++] = TWDR;
 			// fallback
 		case TW_MR_SLA_ACK:
-			reply(ack);
+			// ack all bytes but the last one
+			state = I2C_MRX;
+			reply(xfer_head->rx_count + 1 < xfer_head->rx_len);
 			break;
 		case TW_MR_DATA_NACK:
-            if (masterRxHandler) {
-                masterRxHandler(TWDR);
-            }
-			// fallback
+			xfer_head->rx[xfer_head->rx_count++] = TWDR;
+			master_done(I2C_E_OK);
+			break;
 		case TW_MR_SLA_NACK:
-			send_stop();
+			master_done(I2C_E_ADDR_NACK);
 			break;
 		/*}}}*/
 
@@ -289,7 +436,8 @@ ISR(SIG_2WIRE_SERIAL)
 		/*{{{*/
 		case TW_START:
 		case TW_REP_START:
-			TWDR = slarw;
+			TWDR = (xfer_head->addr << 1) |
+				(master_reading(xfer_head) ? TW_READ : TW_WRITE);
 			reply(1);
 			break;
 		/*}}}*/
@@ -300,9 +448,15 @@ ISR(SIG_2WIRE_SERIAL)
 		case TW_NO_INFO:
 			break;
 		case TW_BUS_ERROR:
+#ifdef HAL_I2C_STATS
+		  stats.bus_errors++;
+#endif
 #ifdef I2C_MASTER
-		  error = I2C_E_BUS;
-		  send_stop();
+		  if (state == I2C_MSTART || state == I2C_MTX || state == I2C_MRX) {
+			  master_done(I2C_E_BUS);
+		  } else {
+			  send_stop();
+		  }
 #else
 		  release();
 #endif
@@ -311,75 +465,111 @@ ISR(SIG_2WIRE_SERIAL)
 		/*}}}*/
 
 	}
+
+#ifdef HAL_I2C_STATS
+	// slave events stretch SCL until TWINT is cleared (not after STOP)
+	uint32_t isr_end = systick_cycles();
+
+	// cycle counter wrapped: skip sample, like core/scheduler.c
+	if (status >= TW_SR_SLA_ACK && status <= TW_ST_LAST_DATA &&
+		isr_end >= isr_start)
+	{
+		uint16_t t = isr_end - isr_start;
+
+		if (status != TW_SR_STOP) {
+			stats.stretch_cycles += t;
+		}
+		if (t > stats.isr_max) {
+			stats.isr_max = t;
+		}
+	}
+#endif
 }
 
 
 #ifdef I2C_MASTER
-uint8_t i2c_lld_start_transmission(uint8_t addr)
+/** Serve transfer to the local address with the slave handlers
+ */
+static void route_local(i2c_xfer_t *x)
 {
-	if (i2c_lld_get_local() != addr) {
-		// real request
-		while (state != I2C_IDLE) {
-#  ifdef I2C_NO_ISR
-			i2c_lld_loop();
-#  endif
-		};
-
-		error = I2C_E_OK;
-		slarw = TW_WRITE | (addr << 1);
-		state = I2C_MSTART;
-		TWCR = 
-				_BV(TWINT)
-			|	_BV(TWSTA)
-			|	_BV(TWEN)
-			|	TWCR_TWIE_IF_ISR
-			;
+	uint8_t status = I2C_E_OK;
+	uint8_t c;
+	bool ack;
 
-		while (state != I2C_IDLE) {
-#  ifdef I2C_NO_ISR
-			i2c_lld_loop();
-#  endif
-		};
-	} else {
-		uint8_t c;
-		// route local
+	// keep bus slave events out meanwhile
+	i2c_lld_lock();
+	if (x->tx_len || !x->rx_len) {
 		startHandler(false);
-		while (masterTxHandler(&c, NULL)) { // NULL -- hack
-			slaveRxHandler(c);
+		while (x->tx_count < x->tx_len) {
+			if (!slaveRxHandler(x->tx[x->tx_count])) {
+				status = I2C_E_DATA_NACK;
+				break;
+			}
+			x->tx_count++;
 		}
 		stopHandler();
 	}
-    return error;
-}
+	// slave sees repeated START as STOP (TW_SR_STOP), then START
+	if (status == I2C_E_OK && x->rx_len) {
+		startHandler(true);
+		while (x->rx_count < x->rx_len) {
+			ack = x->rx_count + 1 < x->rx_len;
+			slaveTxHandler(&c, &ack);
+			x->rx[x->rx_count++] = c;
+		}
+		stopHandler();
+	}
+	i2c_lld_unlock();
 
+	x->status = status;
+	// slave side done too, as after TW_SR_STOP and TW_ST_LAST_DATA
+	gate_event_post(GATE_EVT_I2C | GATE_EVT_I2C_MASTER);
+	if (x->done) {
+		x->done(x);
+	}
+}
 
-uint8_t i2c_lld_request(uint8_t addr)
+void i2c_lld_submit(i2c_xfer_t *xfer)
 {
-	if (i2c_lld_get_local() != addr) {
-		// real request
-		slarw = TW_READ | (addr << 1);
+	xfer->status = I2C_E_PENDING;
+	xfer->tx_count = 0;
+	xfer->rx_count = 0;
+	xfer->next = NULL;
+
+	if (xfer->addr == i2c_lld_get_local()) {
+		route_local(xfer);
+		return;
+	}
 
-		state = I2C_MRX;
-		error = I2C_E_OK;
-		TWCR = 
-				_BV(TWINT)
-			|	_BV(TWSTA)
-			|	_BV(TWEN)
-			|	TWCR_TWIE_IF_ISR
-			;
-		while (state == I2C_MRX);
-	} else {
-		// route local
-		bool ack=true;
-		uint8_t c;
-		startHandler(true);
-		while (ack) {
-			slaveTxHandler(&c, NULL); // NULL -- hack
-			ack = masterRxHandler(c);
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		if (xfer_head) {
+			xfer_tail->next = xfer;
+		} else {
+			xfer_head = xfer;
 		}
-		stopHandler();
+		xfer_tail = xfer;
+		// otherwise the interrupt starts it after the current transfer
+		if (state == I2C_IDLE) {
+			master_start(false);
+		}
+	}
+}
+
+uint8_t i2c_lld_wait(i2c_xfer_t *xfer)
+{
+	while (xfer->status == I2C_E_PENDING) {
+#  ifdef I2C_NO_ISR
+		i2c_lld_loop();
+#  endif
+		i2c_lld_check();
 	}
-	return error;
+	return xfer->status;
+}
+
+uint8_t i2c_lld_transfer(i2c_xfer_t *xfer)
+{
+	i2c_lld_submit(xfer);
+	return i2c_lld_wait(xfer);
 }
 #endif // I2C_MASTER
 
@@ -465,8 +655,198 @@ uint8_t i2c_lld_get_local(void)
 }
 #endif
 
-void i2c_lld_clearbus(void)
+static inline bool line_high(uint8_t bit)
+{
+	return I2C_PIN & _BV(bit);
+}
+
+static inline void line_low(uint8_t bit)
+{
+	I2C_PORT &= ~_BV(bit);
+	I2C_DDR |= _BV(bit);
+}
+
+// input with pull-up
+static inline void line_release(uint8_t bit)
+{
+	I2C_DDR &= ~_BV(bit);
+	I2C_PORT |= _BV(bit);
+}
+
+/** Release SCL, wait while a slave stretches it
+ * @return false if SCL is still low
+ */
+static bool scl_release(void)
+{
+	uint16_t n = I2C_STRETCH_US;
+
+	line_release(I2C_SCL);
+	while (!line_high(I2C_SCL)) {
+		if (!n--) {
+			return false;
+		}
+		_delay_us(1);
+	}
+	return true;
+}
+
+/** Clock a slave holding SDA off the bus, then send STOP
+ * TWI must be off.
+ * @return I2C_E_OK if both lines are high
+ */
+static uint8_t bus_recover(void)
 {
-	// TODO
+	line_release(I2C_SDA);
+	scl_release();
+
+	// slave lets SDA go within a byte and its ack
+	for (uint8_t i = 0; i < 9 && !line_high(I2C_SDA); i++) {
+		line_low(I2C_SCL);
+		_delay_us(I2C_RECOVERY_US);
+		if (!scl_release()) {
+			break;
+		}
+		_delay_us(I2C_RECOVERY_US);
+	}
+
+	// STOP: SDA rises while SCL is high
+	line_low(I2C_SCL);
+	_delay_us(I2C_RECOVERY_US);
+	line_low(I2C_SDA);
+	_delay_us(I2C_RECOVERY_US);
+	scl_release();
+	_delay_us(I2C_RECOVERY_US);
+	line_release(I2C_SDA);
+	_delay_us(I2C_RECOVERY_US);
+
+	return (line_high(I2C_SCL) && line_high(I2C_SDA)) ? I2C_E_OK : I2C_E_BUS;
 }
 
+/** Fail the head transfer, recover the bus, go on with the queue
+ */
+static uint8_t bus_reset(uint8_t abort_status)
+{
+	uint8_t status;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+#ifdef I2C_MASTER
+		// slave transaction is cut: close it as on STOP, so the
+		// register window it holds is released
+		if ((state == I2C_SRX || state == I2C_STX) && stopHandler) {
+			stopHandler();
+		}
+#endif
+		// TWI off: no interrupts, lines are port pins
+		TWCR = 0;
+#ifdef I2C_MASTER
+		state = I2C_IDLE;
+		if (xfer_head) {
+			master_finish(abort_status);
+		}
+#endif
+	}
+
+	status = bus_recover();
+#ifdef HAL_I2C_STATS
+	if (status != I2C_E_OK) {
+		stats.bus_errors++;
+	}
+#endif
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		TWCR =
+				_BV(TWINT)
+			|	_BV(TWEA)
+			|	_BV(TWEN)
+			|	TWCR_TWIE_IF_ISR
+			;
+#ifdef I2C_MASTER
+		if (xfer_head) {
+			master_start(false);
+		}
+#endif
+	}
+	return status;
+}
+
+#ifdef I2C_MASTER
+/** Head transfer is past its deadline
+ */
+static bool master_stuck(void)
+{
+	bool stuck;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		stuck = xfer_head && systick_after_eq(systick_get(), deadline);
+	}
+	return stuck;
+}
+#endif
+
+uint8_t i2c_lld_clearbus(void)
+{
+#ifdef I2C_MASTER
+	// a transfer going on is not cut, its deadline covers a stuck bus
+	if (state != I2C_IDLE && !master_stuck()) {
+		return I2C_E_OK;
+	}
+#endif
+	return bus_reset(I2C_E_BUS);
+}
+
+#ifdef I2C_MASTER
+void i2c_lld_check(void)
+{
+	if (master_stuck()) {
+		bus_reset(I2C_E_TIMEOUT);
+	}
+}
+#endif
+
+// TWINT is written as 0 to keep a pending event
+void i2c_lld_lock(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		TWCR = TWCR & ~(_BV(TWIE) | _BV(TWINT));
+#ifdef HAL_I2C_STATS
+		lock_start = systick_cycles();
+#endif
+	}
+}
+
+void i2c_lld_unlock(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+#ifdef HAL_I2C_STATS
+		uint8_t status = TWSR & 0xF8;
+		uint32_t now = systick_cycles();
+
+		// slave event held back: SCL was stretched for the lock, at most;
+		// cycle counter wrapped: skip sample
+		if ((TWCR & _BV(TWINT)) && status >= TW_SR_SLA_ACK &&
+			status <= TW_ST_LAST_DATA && status != TW_SR_STOP &&
+			now >= lock_start)
+		{
+			stats.stretch_cycles += now - lock_start;
+		}
+#endif
+		TWCR = (TWCR & ~_BV(TWINT)) | TWCR_TWIE_IF_ISR;
+	}
+}
+
+#ifdef HAL_I2C_STATS
+void i2c_lld_stats_read(i2c_stats_t *s)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		*s = stats;
+	}
+}
+
+void i2c_lld_stats_reset(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		memset(&stats, 0, sizeof(stats));
+	}
+}
+#endif
+
@@ -11,21 +11,58 @@
 #define I2C_E_DATA_NACK	3
 #define I2C_E_BUS		4
 #define I2C_E_BUFSIZE	5
+#define I2C_E_TIMEOUT	6
+#define I2C_E_PENDING	0xff	///< transfer is queued or on the bus
 
 
+/// Master transfer timeout, plus 1 ms per byte (enough down to 10 kHz)
+#ifndef I2C_TIMEOUT_MS
+#define I2C_TIMEOUT_MS	25
+#endif
+
 typedef bool (*i2cRxHandler)(uint8_t);
 typedef bool (*i2cTxHandler)(uint8_t*, bool*);
 
 typedef bool (*i2cStartHandler)(uint8_t flag);
 typedef void (*i2cStopHandler)(void);
 
+typedef struct i2c_xfer_s i2c_xfer_t;
+
+/** Master transfer done callback
+ * Called from the TWI interrupt, or from i2c_lld_submit() for the
+ * local address.
+ */
+typedef void (*i2cDoneHandler)(i2c_xfer_t *);
+
+/** Master transfer
+ * Writes tx_len bytes of tx, then reads rx_len bytes into rx, with a
+ * repeated START between them (the bus is not released, a register
+ * read is one transaction). Without both it only checks that the
+ * address is acknowledged.
+ * The descriptor and its buffers belong to the caller and must stay
+ * until the transfer is done.
+ */
+struct i2c_xfer_s {
+	uint8_t addr;            ///< 7-bit slave address
+	uint8_t tx_len;
+	uint8_t rx_len;
+	const uint8_t *tx;
+	uint8_t *rx;
+	i2cDoneHandler done;     ///< may be NULL
+
+	// set by the driver
+	volatile uint8_t status; ///< I2C_E_PENDING, then I2C_E_*
+	uint8_t tx_count;        ///< bytes written and acknowledged
+	uint8_t rx_count;        ///< bytes read
+	i2c_xfer_t *next;
+};
+
 
 void i2c_lld_init(void);
 void i2c_lld_init_slave(uint8_t addr);
 
 void i2c_lld_set_evt_handlers(i2cStartHandler, i2cStopHandler);
 void i2c_lld_set_slave_handlers(i2cRxHandler, i2cTxHandler);
-void i2c_lld_set_master_handlers(i2cRxHandler, i2cTxHandler);
 
 /** Configure the I2C hardware.
  * @param freq the clock frequency in kHz of the I2C master.
@@ -43,11 +80,76 @@ void i2c_lld_set_local(uint8_t addr);
 uint8_t i2c_lld_get_local(void);
 
 /** Reset I2C controller and bus
+ * Only an idle bus, or one with a master transfer past its deadline,
+ * is reset; a transfer going on is left alone. The stuck transfer
+ * fails with I2C_E_BUS, a cut slave transaction is closed with the
+ * stop handler. SCL is clocked until a slave holding SDA lets it go
+ * (9 clocks at most), then STOP is sent and queued transfers go on.
+ * @return I2C_E_OK, I2C_E_BUS if SCL or SDA is still held low
+ */
+uint8_t i2c_lld_clearbus(void);
+
+/** Hold back slave events
+ * TWI interrupt is masked, the bus is stretched until i2c_lld_unlock().
+ * Master requests must not be issued while locked.
+ */
+void i2c_lld_lock(void);
+void i2c_lld_unlock(void);
+
+/** Queue master transfer
+ * Queued transfers run back to back from the TWI interrupt, in submit
+ * order; GATE_EVT_I2C_MASTER is posted as each one is done.
+ * Transfers to the local address are served by the slave handlers at
+ * once, ahead of the queued ones.
+ * The transfer must not be pending already.
+ */
+void i2c_lld_submit(i2c_xfer_t *xfer);
+
+/** Time out stuck master transfer
+ * A transfer not done I2C_TIMEOUT_MS (plus 1 ms per byte) after its
+ * START fails with I2C_E_TIMEOUT and the bus is cleared. Call
+ * periodically; i2c_lld_wait() calls it too.
+ */
+void i2c_lld_check(void);
+
+/** Wait for a submitted transfer
+ * @return transfer status
+ */
+uint8_t i2c_lld_wait(i2c_xfer_t *xfer);
+
+/** Submit transfer and wait for it
+ * @return transfer status
  */
-void i2c_lld_clearbus(void);
+uint8_t i2c_lld_transfer(i2c_xfer_t *xfer);
 
-uint8_t i2c_lld_start_transmission(uint8_t);
-uint8_t i2c_lld_request(uint8_t);
+#if defined(HAL_I2C_STATS) || defined(__DOXYGEN__)
+/** Bus statistics (only with HAL_I2C_STATS)
+ * Master counters cover bus transfers, not the ones routed to the
+ * local address. Time is in CPU cycles, as precise as the systick
+ * timer prescaler.
+ */
+typedef struct {
+	uint32_t m_xfers;        ///< master transfers done
+	uint32_t m_bytes;        ///< bytes written and read by them
+	uint32_t s_xfers;        ///< slave transactions (own address)
+	uint32_t s_bytes;        ///< bytes received and sent by them
+	uint16_t addr_nack;      ///< master transfers with I2C_E_ADDR_NACK
+	uint16_t data_nack;      ///< master transfers with I2C_E_DATA_NACK
+	uint16_t arb_lost;       ///< master transfers with I2C_E_ARB
+	uint16_t bus_errors;     ///< illegal START/STOP, failed bus recovery
+	uint16_t timeouts;       ///< master transfers with I2C_E_TIMEOUT
+	uint32_t stretch_cycles; ///< SCL held low by slave interrupts
+	uint16_t isr_max;        ///< longest slave interrupt
+} i2c_stats_t;
+
+/** Copy statistics (consistent snapshot)
+ */
+void i2c_lld_stats_read(i2c_stats_t *stats);
+
+/** Reset statistics
+ */
+void i2c_lld_stats_reset(void);
+#endif
 
 #ifdef I2C_NO_ISR
 #define I2C_FLAG_SET() (TWCR & _BV(TWINT))
@@ -1,12 +1,19 @@
 # -*- Makefile -*-
 
 DEFINES += -DI2C_SLAVE -DI2C_MASTER
+ifeq ($(I2C_STATS),yes)
+	DEFINES += -DHAL_I2C_STATS
+endif
 INCLUDE_DIRS += -I${ORFA}/hal/i2c
-HAL_SRC += ${ORFA}/hal/i2c/i2c_lld.c
+
+ifeq ($(PLATFORM),HOST_SIM)
+	HAL_SRC += ${ORFA}/hal/i2c/host/i2c_lld.c
+else
+	HAL_SRC += ${ORFA}/hal/i2c/i2c_lld.c
+endif
 
 ifeq "$(I2C_SLAVE_ADDRESS)" ""
     I2C_SLAVE_ADDRESS = 0x7F
 endif
 
 DEFINES += -DI2C_SLAVE_ADDRESS=$(I2C_SLAVE_ADDRESS)
-
@@ -0,0 +1,54 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Motor driver for the host simulation
+ * @file motor/host/motor_lld.h
+ */
+
+#ifndef MOTORLLD_H
+#define MOTORLLD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/// Simulated direction outputs
+extern bool motor_lld_dir[2];
+
+/// Simulated PWM compare values
+extern uint8_t motor_lld_pwm[2];
+
+#define motor_lld_set_direction(ch, value) \
+	do { motor_lld_dir[ch] = (value) ? true : false; } while(0)
+
+#define motor_lld_set_pwm(ch, value) \
+	do { motor_lld_pwm[ch] = (uint8_t) (value); } while(0)
+
+#define motor_lld_get_direction(ch) \
+	(motor_lld_dir[ch])
+
+#define motor_lld_get_pwm(ch) \
+	(motor_lld_pwm[ch])
+
+void motor_lld_init(void);
+
+#endif // MOTORLLD_H
@@ -1,6 +1,8 @@
 # -*- Makefile -*-
 
-ifeq ($(PLATFORM),OR_AVR_M32_D)
+ifeq ($(PLATFORM),HOST_SIM)
+	MLLD = host
+else ifeq ($(PLATFORM),OR_AVR_M32_D)
 	MLLD = m32
 else ifeq ($(PLATFORM),OR_AVR_M16_DS)
 	MLLD = m16
@@ -51,6 +51,38 @@
 #define serial_putchar(c) \
 	serial_lld_putchar(c)
 
+/** Send one byte as is (no newline translation)
+ * @param[in] c byte
+ */
+#define serial_putbyte(c) \
+	serial_lld_putbyte(c)
+
+/** Set line start handler
+ * @param[in] line called before the first character of each output line
+ */
+#define serial_set_line_handler(line) \
+	serial_lld_set_line_handler(line)
+
+/** Send buffer as is
+ * @param[in] buf data
+ * @param[in] len data length
+ */
+#define serial_write(buf, len) \
+	serial_lld_write(buf, len)
+
+/** Check that all queued output is sent
+ */
+#define serial_tx_isempty() \
+	serial_lld_tx_isempty()
+
+/** Take received bytes without waiting
+ * @param[out] buf destination
+ * @param[in] len max bytes
+ * @return bytes taken
+ */
+#define serial_read(buf, len) \
+	serial_lld_read(buf, len)
+
 /** Receive one character
  */
 #define serial_getchar() \
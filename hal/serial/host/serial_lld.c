@@ -0,0 +1,239 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Serial port for the host simulation
+ * @file serial/host/serial_lld.c
+ */
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+// termios speed constants clash with the HAL baud rate names
+#undef B115200
+#undef B57600
+#undef B38400
+#undef B19200
+#undef B9600
+#undef B4800
+#undef B2400
+
+#include "host.h"
+#include "serial_lld.h"
+#include "core/event.h"
+
+FILE* serial_lld_file;
+
+static int rx_fd = 0;
+static int tx_fd = 1;
+static uint8_t udr;
+
+// rx ring, same as the AVR one
+#define SERIAL_RX_LEN  128
+#define SERIAL_RX_MASK (SERIAL_RX_LEN - 1)
+
+static uint8_t rx_buf[SERIAL_RX_LEN];
+static volatile uint8_t rx_head;
+static volatile uint8_t rx_tail;
+
+static struct termios saved_tio;
+static bool tio_saved;
+
+static void rx_isr(void)
+{
+	rx_buf[rx_head] = udr;
+	rx_head = (rx_head + 1) & SERIAL_RX_MASK;
+	gate_event_post_isr(GATE_EVT_SERIAL);
+}
+
+static void rx_ready(int fd)
+{
+	uint8_t buf[64];
+	ssize_t i, n;
+
+	n = read(fd, buf, sizeof(buf));
+	if (n <= 0) {
+		// end of input: quit once all of it is processed
+		host_fd_remove(fd);
+		host_exit_when_idle();
+		return;
+	}
+
+	for (i = 0; i < n; i++) {
+		// wait for the firmware to drain the buffer, like a slow line
+		while (((rx_head + 1) & SERIAL_RX_MASK) == rx_tail) {
+			usleep(100);
+		}
+		udr = buf[i];
+		host_irq_run(rx_isr);
+	}
+}
+
+bool serial_lld_isempty(void)
+{
+	return rx_head == rx_tail;
+}
+
+uint8_t serial_lld_read(uint8_t *buf, uint8_t len)
+{
+	uint8_t head = rx_head;
+	uint8_t tail = rx_tail;
+	uint8_t n = 0;
+
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	while (n < len && tail != head) {
+		buf[n++] = rx_buf[tail];
+		tail = (tail + 1) & SERIAL_RX_MASK;
+	}
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	rx_tail = tail;
+	return n;
+}
+
+static serialLineHandler lineHandler;
+static bool line_start = true;
+
+void serial_lld_set_line_handler(serialLineHandler line)
+{
+	lineHandler = line;
+}
+
+int serial_lld_fputchar(char c, FILE *stream)
+{
+	(void)stream;
+	if (line_start) {
+		line_start = false;
+		if (lineHandler) {
+			lineHandler();
+		}
+	}
+	if (c == '\n') {
+		line_start = true;
+		serial_lld_putbyte('\r');
+	}
+	return write(tx_fd, &c, 1) == 1 ? 0 : -1;
+}
+
+void serial_lld_putbyte(uint8_t c)
+{
+	if (write(tx_fd, &c, 1) != 1) {
+		// nothing to do, like a disconnected line
+	}
+}
+
+void serial_lld_write(const uint8_t *buf, uint8_t len)
+{
+	if (write(tx_fd, buf, len) != len) {
+		// nothing to do, like a disconnected line
+	}
+}
+
+int serial_lld_fgetchar(FILE *stream)
+{
+	uint8_t c;
+	(void)stream;
+
+	while (!serial_lld_read(&c, 1)) {
+		usleep(100);
+	}
+
+	return c;
+}
+
+static ssize_t cookie_read(void* cookie, char* buf, size_t size)
+{
+	(void)cookie;
+	if (!size) {
+		return 0;
+	}
+	*buf = serial_lld_fgetchar(NULL);
+	return 1;
+}
+
+static ssize_t cookie_write(void* cookie, const char* buf, size_t size)
+{
+	size_t i;
+	(void)cookie;
+
+	for (i = 0; i < size; i++) {
+		serial_lld_fputchar(buf[i], NULL);
+	}
+	return size;
+}
+
+static void restore_tty(void)
+{
+	if (tio_saved) {
+		tcsetattr(rx_fd, TCSANOW, &saved_tio);
+	}
+}
+
+static void open_pty(void)
+{
+	int fd = posix_openpt(O_RDWR | O_NOCTTY);
+	struct termios tio;
+
+	if (fd < 0 || grantpt(fd) || unlockpt(fd)) {
+		host_log("serial: can't open pty, using stdin/stdout\n");
+		return;
+	}
+
+	// raw line, like a real USART
+	tcgetattr(fd, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(fd, TCSANOW, &tio);
+
+	rx_fd = tx_fd = fd;
+	host_log("serial: %s\n", ptsname(fd));
+}
+
+void serial_lld_init(uint16_t baud)
+{
+	cookie_io_functions_t io = {
+		.read = cookie_read,
+		.write = cookie_write,
+	};
+	(void)baud;
+
+	if (getenv("ORFA_SIM_PTY")) {
+		open_pty();
+	}
+
+	if (rx_fd == 0 && isatty(rx_fd) && !tcgetattr(rx_fd, &saved_tio)) {
+		// byte at a time, no echo; ^C still works
+		struct termios tio = saved_tio;
+		tio.c_lflag &= ~(ICANON | ECHO);
+		tio.c_cc[VMIN] = 1;
+		tio.c_cc[VTIME] = 0;
+		tcsetattr(rx_fd, TCSANOW, &tio);
+		tio_saved = true;
+		atexit(restore_tty);
+	}
+
+	serial_lld_file = fopencookie(NULL, "r+", io);
+	setvbuf(serial_lld_file, NULL, _IONBF, 0);
+
+	host_fd_add(rx_fd, rx_ready);
+}
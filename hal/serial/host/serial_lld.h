@@ -0,0 +1,88 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Serial port for the host simulation
+ * @file serial/host/serial_lld.h
+ *
+ * The simulated USART is connected to stdin/stdout, or to a pseudo
+ * terminal when ORFA_SIM_PTY is set in the environment.
+ */
+
+#ifndef SERIAL_LLD_H
+#define SERIAL_LLD_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/// Baud rate has no meaning here, kept for configuration compatibility
+#define SERIAL_BAUD(baud) ((uint16_t)((F_CPU / (16.0 * (baud))) + 0.5) - 1)
+
+#define B115200 (SERIAL_BAUD(115200L))
+#define B76800  (SERIAL_BAUD(76800UL))
+#define B57600  (SERIAL_BAUD(57600UL))
+#define B38400  (SERIAL_BAUD(38400UL))
+#define B28800  (SERIAL_BAUD(28800U))
+#define B19200  (SERIAL_BAUD(19200U))
+#define B14400  (SERIAL_BAUD(14400))
+#define B9600   (SERIAL_BAUD(9600))
+#define B4800   (SERIAL_BAUD(4800))
+#define B2400   (SERIAL_BAUD(2400))
+#define B_AUTO  0
+
+// indicate fdev
+#define HAL_HAVE_SERIAL_FILE_DEVICE
+
+/// Serial stream (stdio cookie stream)
+extern FILE* serial_lld_file;
+
+/// Serial file device
+#define serial_lld_fdev (*serial_lld_file)
+
+void serial_lld_init(uint16_t baud);
+
+#define serial_lld_putchar(c) \
+	serial_lld_fputchar(c, (FILE*)0)
+
+int serial_lld_fputchar(char c, FILE *stream);
+
+typedef void (*serialLineHandler)(void);
+
+void serial_lld_set_line_handler(serialLineHandler line);
+
+void serial_lld_putbyte(uint8_t c);
+
+void serial_lld_write(const uint8_t *buf, uint8_t len);
+
+#define serial_lld_tx_isempty() true
+
+#define serial_lld_getchar() \
+	serial_lld_fgetchar((FILE*)0)
+
+int serial_lld_fgetchar(FILE *stream);
+
+bool serial_lld_isempty(void);
+
+uint8_t serial_lld_read(uint8_t *buf, uint8_t len);
+
+#endif // SERIAL_LLD_H
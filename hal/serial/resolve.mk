@@ -1,6 +1,9 @@
 # -*- Makefile -*-
 
-INCLUDE_DIRS += -I${ORFA}/hal/serial
-
-HAL_SRC += ${ORFA}/hal/serial/serial_lld.c
-
+ifeq ($(PLATFORM),HOST_SIM)
+	INCLUDE_DIRS += -I${ORFA}/hal/serial/host
+	HAL_SRC += ${ORFA}/hal/serial/host/serial_lld.c
+else
+	INCLUDE_DIRS += -I${ORFA}/hal/serial
+	HAL_SRC += ${ORFA}/hal/serial/serial_lld.c
+endif
@@ -32,7 +32,7 @@
 
 #include <avr/interrupt.h>
 #include <util/atomic.h>
-#include "lib/cbuf.h"
+#include "core/event.h"
 
 
 PROGMEM int16_t baud_cycles[] = {
@@ -50,31 +50,132 @@ PROGMEM int16_t baud_cycles[] = {
 };
 
 #ifndef HAL_SERIAL_NISR
-// static volatile give compilation errors :(
-static cbf_t rx_cbf;
+// rx ring, written by RXC interrupt only, read by tasks only:
+// single byte indexes need no atomic blocks
+#define SERIAL_RX_MASK (SERIAL_RX_LEN - 1)
+
+static uint8_t rx_buf[SERIAL_RX_LEN];
+static volatile uint8_t rx_head; ///< next free slot
+static volatile uint8_t rx_tail; ///< next byte to read
 
 bool serial_lld_isempty(void)
 {
-	bool ret;
+	return rx_head == rx_tail;
+}
+
+ISR(SERIAL_RXC_vect)
+{
+	uint8_t c = SERIAL_UDR;
+	uint8_t head = rx_head;
+	uint8_t next = (head + 1) & SERIAL_RX_MASK;
 
-	ATOMIC_BLOCK(ATOMIC_FORCEON) {
-		ret = cbf_isempty(&rx_cbf);
+	// drop on overflow
+	if (next != rx_tail) {
+		rx_buf[head] = c;
+		rx_head = next;
 	}
-	return ret;
+	gate_event_post_isr(GATE_EVT_SERIAL);
 }
 
-ISR(SERIAL_RXC_vect)
+uint8_t serial_lld_read(uint8_t *buf, uint8_t len)
 {
-	uint8_t c=SERIAL_UDR;
-	cbf_put(&rx_cbf, c);
+	uint8_t head = rx_head;
+	uint8_t tail = rx_tail;
+	uint8_t n = 0;
+
+	while (n < len && tail != head) {
+		buf[n++] = rx_buf[tail];
+		tail = (tail + 1) & SERIAL_RX_MASK;
+	}
+	rx_tail = tail;
+	return n;
 }
 #else
 bool serial_lld_isempty(void)
 {
 	return bit_is_clear(SERIAL_UCSRA, RXC);
 }
+
+uint8_t serial_lld_read(uint8_t *buf, uint8_t len)
+{
+	uint8_t n = 0;
+
+	while (n < len && bit_is_set(SERIAL_UCSRA, RXC)) {
+		buf[n++] = SERIAL_UDR;
+	}
+	return n;
+}
 #endif
 
+#ifndef HAL_SERIAL_TX_NISR
+// tx ring, written by tasks, drained by UDRE interrupt
+#define SERIAL_TX_MASK (SERIAL_TX_LEN - 1)
+
+static uint8_t tx_buf[SERIAL_TX_LEN];
+static volatile uint8_t tx_head; ///< next free slot
+static volatile uint8_t tx_tail; ///< next byte to send
+#  ifdef HAL_SERIAL_TX_DROP
+uint16_t serial_lld_tx_dropped;
+#  endif
+
+ISR(SERIAL_UDRE_vect)
+{
+	uint8_t tail = tx_tail;
+
+	if (tail != tx_head) {
+		SERIAL_UDR = tx_buf[tail];
+		tx_tail = (tail + 1) & SERIAL_TX_MASK;
+	} else {
+		SERIAL_UCSRB &= ~_BV(UDRIE);
+	}
+}
+
+static inline void tx_kick(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		SERIAL_UCSRB |= _BV(UDRIE);
+	}
+}
+
+/** Wait for free space in tx ring
+ * With interrupts disabled (ISR, init) the ring is drained by polling.
+ * @return false if the byte must be dropped
+ */
+static bool tx_wait(void)
+{
+	tx_kick();
+#  ifdef HAL_SERIAL_TX_DROP
+	if (bit_is_set(SREG, SREG_I)) {
+		serial_lld_tx_dropped++;
+		return false;
+	}
+#  endif
+	while (((tx_head + 1) & SERIAL_TX_MASK) == tx_tail) {
+		if (bit_is_clear(SREG, SREG_I)) {
+			loop_until_bit_is_set(SERIAL_UCSRA, UDRE);
+			SERIAL_UDR = tx_buf[tx_tail];
+			tx_tail = (tx_tail + 1) & SERIAL_TX_MASK;
+		}
+	}
+	return true;
+}
+
+/** Put byte into tx ring, interrupt is not kicked
+ */
+static inline void tx_put(uint8_t c)
+{
+	uint8_t head = tx_head;
+	uint8_t next = (head + 1) & SERIAL_TX_MASK;
+
+	if (next == tx_tail) {
+		if (!tx_wait())
+			return;
+	}
+	tx_buf[head] = c;
+	tx_head = next;
+}
+#endif // HAL_SERIAL_TX_NISR
+
 // autodetecting baud rate
 // need send "\x0d\x0d\x0d\x0d\x0d\x0d\x0d\x0d"
 static uint16_t detect_baud_rate(void)
@@ -178,9 +279,13 @@ void serial_lld_init(uint16_t baud)
 	// output the upper four bits of the baudrate divisor
 	SERIAL_UBRRH = (baud >> 8) & 0x0F;
 
+#ifndef HAL_SERIAL_TX_NISR
+	tx_head = tx_tail = 0;
+#endif
+
 #ifndef HAL_SERIAL_NISR
 	// init rx buffer
-	cbf_init(&rx_cbf);
+	rx_head = rx_tail = 0;
 	// enable the SERIAL0 transmitter & receiver & receiver interrupt
 	SERIAL_UCSRB = (1 << RXCIE) | (1 << TXEN) | (1 << RXEN);
 #else
@@ -189,20 +294,75 @@ void serial_lld_init(uint16_t baud)
 #endif
 }
 
+static serialLineHandler lineHandler;
+static bool line_start = true;
+
+void serial_lld_set_line_handler(serialLineHandler line)
+{
+	lineHandler = line;
+}
+
 /*
- * Send character c down the UART Tx, wait until tx holding register
- * is empty.
+ * Send character c down the UART Tx.
  */
 int serial_lld_fputchar(char c, FILE *stream)
 {
 	(void)stream;
-	if ( c == '\n' )
-		serial_lld_fputchar('\r', stream);
+	if (line_start) {
+		line_start = false;
+		if (lineHandler)
+			lineHandler();
+	}
+	if ( c == '\n' ) {
+		line_start = true;
+		serial_lld_putbyte('\r');
+	}
+	serial_lld_putbyte(c);
+
+	return 0;
+}
+
+#ifndef HAL_SERIAL_TX_NISR
+void serial_lld_putbyte(uint8_t c)
+{
+	tx_put(c);
+	tx_kick();
+}
+
+void serial_lld_write(const uint8_t *buf, uint8_t len)
+{
+	while (len--) {
+		tx_put(*buf++);
+	}
+	tx_kick();
+}
+
+bool serial_lld_tx_isempty(void)
+{
+	return tx_head == tx_tail;
+}
+#else
+/*
+ * Wait until tx holding register is empty.
+ */
+void serial_lld_putbyte(uint8_t c)
+{
 	loop_until_bit_is_set(SERIAL_UCSRA, UDRE);
 	SERIAL_UDR = c;
+}
 
-	return 0;
+void serial_lld_write(const uint8_t *buf, uint8_t len)
+{
+	while (len--) {
+		serial_lld_putbyte(*buf++);
+	}
+}
+
+bool serial_lld_tx_isempty(void)
+{
+	return true;
 }
+#endif // HAL_SERIAL_TX_NISR
 
 int serial_lld_fgetchar(FILE *stream)
 {	
@@ -213,8 +373,8 @@ int serial_lld_fgetchar(FILE *stream)
 	loop_until_bit_is_set(SERIAL_UCSRA, RXC);
 	c = SERIAL_UDR;
 #else
-	ATOMIC_BLOCK(ATOMIC_FORCEON) {
-		c = cbf_get(&rx_cbf);
+	if (!serial_lld_read(&c, 1)) {
+		c = 0;
 	}
 #endif
 
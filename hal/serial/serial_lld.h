@@ -98,6 +98,30 @@
 #define B2x2400   (SERIAL_2x_BAUD(2400))
 ///@}
 
+/** Receive ring length (power of 2)
+ */
+#ifndef SERIAL_RX_LEN
+#define SERIAL_RX_LEN 128
+#endif
+
+/** Transmit ring length (power of 2)
+ * Output is queued and sent by the UDRE interrupt, so printing does
+ * not stall the scheduler for the time the text takes on the line.
+ * When the ring is full the writer waits for free space (with
+ * interrupts disabled the ring is drained by polling). With
+ * HAL_SERIAL_TX_DROP the byte is dropped and counted in
+ * serial_lld_tx_dropped instead.
+ * HAL_SERIAL_TX_NISR disables the ring: every byte waits for UDRE.
+ */
+#ifndef SERIAL_TX_LEN
+#define SERIAL_TX_LEN 64
+#endif
+
+#if !defined(HAL_SERIAL_TX_NISR) && defined(HAL_SERIAL_TX_DROP)
+/// Bytes dropped on full transmit ring
+extern uint16_t serial_lld_tx_dropped;
+#endif
+
 // indicate fdev
 #define HAL_HAVE_SERIAL_FILE_DEVICE
 
@@ -128,6 +152,26 @@ void serial_lld_init(uint16_t baud);
  */
 int serial_lld_fputchar(char c, FILE *stream);
 
+/** Line start handler
+ * Called before the first character of each line sent with
+ * serial_lld_fputchar(). May send with serial_lld_putbyte().
+ */
+typedef void (*serialLineHandler)(void);
+
+void serial_lld_set_line_handler(serialLineHandler line);
+
+/** Send one byte as is (no newline translation)
+ */
+void serial_lld_putbyte(uint8_t c);
+
+/** Send buffer as is
+ */
+void serial_lld_write(const uint8_t *buf, uint8_t len);
+
+/** Check that all queued output is passed to the UART
+ */
+bool serial_lld_tx_isempty(void);
+
 /** Receive one character
  */
 #define serial_lld_getchar() \
@@ -142,5 +186,12 @@ int serial_lld_fgetchar(FILE *stream);
  */
 bool serial_lld_isempty(void);
 
+/** Take received bytes without waiting
+ * @param[out] buf  destination
+ * @param[in]  len  max bytes to take
+ * @return number of bytes taken
+ */
+uint8_t serial_lld_read(uint8_t *buf, uint8_t len);
+
 #endif // SERIAL_LLD_H
 
@@ -40,6 +40,7 @@
 	#define SERIAL_UBRRL     UBRRL
 	#define SERIAL_UBRRH     UBRRH
 	#define SERIAL_RXC_vect  USART_RXC_vect
+	#define SERIAL_UDRE_vect USART_UDRE_vect
 
 	#define SERIAL_DDR       DDRD
 	#define SERIAL_PIN       PIND
@@ -53,6 +54,7 @@
 	#define SERIAL_UBRRL     UBRR0L
 	#define SERIAL_UBRRH     UBRR0H
 	#define SERIAL_RXC_vect  USART0_RX_vect
+	#define SERIAL_UDRE_vect USART0_UDRE_vect
 
 	#define SERIAL_DDR       PORTD
 	#define SERIAL_PIN       PIND
@@ -67,6 +69,7 @@
 	#define SERIAL_UBRRL     UBRR1L
 	#define SERIAL_UBRRH     UBRR1H
 	#define SERIAL_RXC_vect  USART1_RX_vect
+	#define SERIAL_UDRE_vect USART1_UDRE_vect
 
 	#define SERIAL_DDR       PORTD
 	#define SERIAL_PIN       PIND
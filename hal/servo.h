@@ -71,6 +71,13 @@
 #define servo_is_done() \
 	servo_lld_is_done()
 
+/** Copy positions of all servos (coherent frame)
+ * @param[out] pos table of SERVO_LEN values
+ * @return frame sequence number
+ */
+#define servo_get_frame(pos) \
+	servo_lld_get_frame(pos)
+
 /** New servo command
  * @param[in] time
  * @param[in] target
@@ -79,7 +86,7 @@
 #define servo_command(time, target, maxspeed) \
 	servo_lld_command(time, target, maxspeed)
 
-#if defined(HAL_SERVO_NTIM2) || defined(__DOXYGEN__)
+#if defined(HAL_SERVO_NTIM) || defined(__DOXYGEN__)
 /** Servo command periodic
  */
 #define servo_loop \
@@ -0,0 +1,65 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Servo outputs for the host simulation
+ * @file servo/host/servo_lld.c
+ *
+ * Pulse widths are only stored; there are no outputs to drive.
+ */
+
+#include <util/atomic.h>
+
+#include "servo_lld.h"
+
+static uint16_t servo_pos[SERVO_LEN];
+
+uint16_t servo_lld_get_position(uint8_t n)
+{
+	if (n > SERVO_CHMAX)
+		return 0;
+	return servo_pos[n];
+}
+
+void servo_lld_set_position(uint8_t n, uint16_t pos)
+{
+	if (n > SERVO_CHMAX)
+		return;
+
+	if (pos < 500)
+		pos = 500;
+	else if (pos > 2500)
+		pos = 2500;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		servo_pos[n] = pos;
+	}
+}
+
+void servo_lld_init(void)
+{
+	uint8_t i;
+
+	for (i = 0; i < SERVO_LEN; i++) {
+		servo_pos[i] = 1500;
+	}
+}
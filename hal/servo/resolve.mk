@@ -2,7 +2,10 @@
 
 HAL_SERVO_CMD = yes
 
-ifeq ($(PLATFORM),OR_AVR_M32_D)
+ifeq ($(PLATFORM),HOST_SIM)
+	SLLD = host
+	HAL_SERVO_NTIM = yes
+else ifeq ($(PLATFORM),OR_AVR_M32_D)
 	SLLD = gpio
 	HAL_SERVO_TIM0 = yes
 else
@@ -23,6 +26,10 @@ ifeq ($(HAL_SERVO_TIM0),yes)
 	DEFINES += -DHAL_SERVO_TIM0
 endif
 
+ifeq ($(HAL_SERVO_NTIM),yes)
+	DEFINES += -DHAL_SERVO_NTIM
+endif
+
 INCLUDE_DIRS += -I${ORFA}/hal/servo/${SLLD}
 
 HAL_SRC += ${ORFA}/hal/servo/${SLLD}/servo_lld.c
@@ -34,6 +34,7 @@
 
 #include "servo_cmd_lld.h"
 #include "hal/servo.h"
+#include "core/event.h"
 
 /// Debug print
 #ifndef NDEBUG
@@ -50,8 +51,24 @@ static uint16_t servo_target[SERVO_LEN];
 static uint16_t servo_total_time[SERVO_LEN];
 static uint16_t servo_time_left[SERVO_LEN];
 
+static uint16_t servo_frames[2][SERVO_LEN];
+GATE_SNAPSHOT servo_lld_snapshot = GATE_SNAPSHOT_INIT(servo_frames);
+
+/** Publish current positions as a frame
+ */
+static void publish(void)
+{
+	uint16_t* frame = gate_snapshot_back(&servo_lld_snapshot);
+	for (uint8_t i=0; i<SERVO_LEN; i++)
+		frame[i] = servo_get_position(i);
+	gate_snapshot_publish(&servo_lld_snapshot);
+}
+
 void servo_lld_cmd_init(void)
 {
+	// initial positions, until the first iteration
+	publish();
+
 #ifndef HAL_SERVO_NTIM
 	#ifndef HAL_SERVO_TIM0
 	// Set timer 2 for iterator
@@ -92,7 +109,9 @@ void servo_lld_loop(void)
 {
 	int32_t tmp;
 
+#ifndef HAL_SERVO_NTIM
 	asm volatile ("sei"); // XXX: Warning!
+#endif
 
 	for (uint8_t i=0; i<SERVO_LEN; i++)
 		if (servo_time_left[i] > 0) {
@@ -110,6 +129,14 @@ void servo_lld_loop(void)
 			}
 			servo_set_position(i, tmp);
 		}
+
+	// publish positions of this iteration
+	publish();
+
+#ifndef HAL_SERVO_NTIM
+	// interrupts are enabled here, see sei above
+	gate_event_post(GATE_EVT_SERVO);
+#endif
 }
 
 void servo_lld_command(uint16_t time,
@@ -34,6 +34,20 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "core/snapshot.h"
+
+/** Servo position frames
+ * Each frame is uint16_t[SERVO_LEN], published after every iteration.
+ */
+extern GATE_SNAPSHOT servo_lld_snapshot;
+
+/** Copy positions of all servos from the last iteration
+ * @param[out] pos table of SERVO_LEN values
+ * @return frame sequence number
+ */
+#define servo_lld_get_frame(pos) \
+	gate_snapshot_read(&servo_lld_snapshot, pos)
+
 /** Check that command is done
  */
 bool servo_lld_is_done(void);
@@ -47,7 +61,7 @@ void servo_lld_command(uint16_t time,
  */
 void servo_lld_cmd_init(void);
 
-#if defined(HAL_SEVRO_NTIM) || defined(__DOXYGEN__)
+#if defined(HAL_SERVO_NTIM) || defined(__DOXYGEN__)
 /** Servo commnad periodic
  * @note Call freq 100 Hz
  */
@@ -0,0 +1,73 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** System tick driver
+ * @file hal/systick.h
+ */
+
+#ifndef SYSTICK_H
+#define SYSTICK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Tick counter type
+ * @note wraps around, compare with systick_after_eq() only
+ */
+typedef uint16_t systick_t;
+
+#include "systick_lld.h"
+
+/** Tick frequency in Hz
+ */
+#define SYSTICK_HZ \
+	SYSTICK_LLD_HZ
+
+/** Convert milliseconds to ticks (rounded up)
+ */
+#define SYSTICK_MS(ms) \
+	((systick_t) ((((uint32_t)(ms)) * SYSTICK_HZ + 999UL) / 1000UL))
+
+/** Check that tick @a a is at or after tick @a b
+ */
+#define systick_after_eq(a, b) \
+	((int16_t) ((systick_t)(a) - (systick_t)(b)) >= 0)
+
+/** Init and start tick timer
+ */
+#define systick_init() \
+	systick_lld_init()
+
+/** Get current tick
+ */
+#define systick_get() \
+	systick_lld_get()
+
+/** Get CPU cycle counter
+ * Resolution is the timer prescaler; wraps together with tick counter.
+ */
+#define systick_cycles() \
+	systick_lld_cycles()
+
+#endif // SYSTICK_H
+
@@ -0,0 +1,66 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** System tick for the host simulation
+ * @file systick/host/systick_lld.c
+ *
+ * Tick interrupt from the simulation thread, cycles from the host
+ * monotonic clock scaled to F_CPU.
+ */
+
+#include <time.h>
+#include <util/atomic.h>
+
+#include "host.h"
+#include "systick_lld.h"
+
+static volatile uint16_t ticks;
+
+static void systick_isr(void)
+{
+	ticks++;
+}
+
+uint16_t systick_lld_get(void)
+{
+	uint16_t ret;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		ret = ticks;
+	}
+	return ret;
+}
+
+uint32_t systick_lld_cycles(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * F_CPU
+		+ (uint64_t) ts.tv_nsec * (F_CPU / 1000) / 1000000;
+}
+
+void systick_lld_init(void)
+{
+	host_timer_add(systick_isr, 1000000UL / SYSTICK_LLD_HZ);
+}
@@ -0,0 +1,15 @@
+# -*- Makefile -*-
+
+ifeq ($(PLATFORM),HOST_SIM)
+	STLLD = host
+else ifeq ($(DEBUG),2)
+	STLLD = sim
+else ifeq ($(PLATFORM),OR_AVR_M32_D)
+	STLLD = timer1
+else
+	STLLD = timer0
+endif
+
+INCLUDE_DIRS += -I${ORFA}/hal/systick/${STLLD}
+
+HAL_SRC += ${ORFA}/hal/systick/${STLLD}/systick_lld.c
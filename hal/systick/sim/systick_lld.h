@@ -0,0 +1,47 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Simulated system tick (host builds)
+ * @file systick/sim/systick_lld.h
+ */
+
+#ifndef SYSTICKLLD_H
+#define SYSTICKLLD_H
+
+#include <stdint.h>
+
+#define SYSTICK_LLD_HZ 1000
+/// Simulated cycles per tick (7.3728 MHz)
+#define SYSTICK_LLD_CYCLES 7373UL
+
+void systick_lld_init(void);
+uint16_t systick_lld_get(void);
+uint32_t systick_lld_cycles(void);
+
+/** Advance simulated time
+ * @param[in] ticks number of ticks
+ */
+void systick_lld_advance(uint16_t ticks);
+
+#endif // SYSTICKLLD_H
+
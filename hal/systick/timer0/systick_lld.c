@@ -0,0 +1,95 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** System tick on Timer0 compare match
+ * @file systick/timer0/systick_lld.c
+ *
+ * Timer0 in CTC mode, prescaler 1/64, 1 kHz.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#include "systick_lld.h"
+
+#define SYSTICK_OCR ((F_CPU / 64 / SYSTICK_LLD_HZ) - 1)
+
+static volatile uint16_t ticks;
+
+#ifdef TCCR0A
+ISR(SIG_OUTPUT_COMPARE0A)
+#else
+ISR(SIG_OUTPUT_COMPARE0)
+#endif
+{
+	ticks++;
+}
+
+uint16_t systick_lld_get(void)
+{
+	uint16_t ret;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		ret = ticks;
+	}
+	return ret;
+}
+
+uint32_t systick_lld_cycles(void)
+{
+	uint16_t t;
+	uint8_t cnt;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		t = ticks;
+		cnt = TCNT0;
+#ifdef TCCR0A
+		if (TIFR0 & _BV(OCF0A)) {
+#else
+		if (TIFR & _BV(OCF0)) {
+#endif
+			// compare match pending, ISR not run yet
+			t++;
+			cnt = TCNT0;
+		}
+	}
+	return ((uint32_t) t * (SYSTICK_OCR + 1) + cnt) * 64;
+}
+
+void systick_lld_init(void)
+{
+#ifdef TCCR0A
+	// ATmega168: CS02:0 = 0:1:1 => 1/64
+	OCR0A = SYSTICK_OCR;
+	TCCR0A = _BV(WGM01);
+	TCCR0B = _BV(CS01) | _BV(CS00);
+	TIMSK0 |= _BV(OCIE0A);
+#else
+	// ATmega128: CS02:0 = 1:0:0 => 1/64
+	OCR0 = SYSTICK_OCR;
+	TCCR0 = _BV(WGM01) | _BV(CS02);
+	TIMSK |= _BV(OCIE0);
+#endif
+}
+
@@ -0,0 +1,78 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** System tick on Timer1 overflow
+ * @file systick/timer1/systick_lld.c
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#include "systick_lld.h"
+
+static volatile uint16_t ticks;
+
+ISR(SIG_OVERFLOW1)
+{
+	ticks++;
+}
+
+uint16_t systick_lld_get(void)
+{
+	uint16_t ret;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		ret = ticks;
+	}
+	return ret;
+}
+
+uint32_t systick_lld_cycles(void)
+{
+	uint16_t t;
+	uint8_t cnt;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		t = ticks;
+		cnt = TCNT1L;
+		if (TIFR & _BV(TOV1)) {
+			// overflow pending, ISR not run yet
+			t++;
+			cnt = TCNT1L;
+		}
+	}
+	return ((uint32_t) t * 256 + cnt) * 8;
+}
+
+void systick_lld_init(void)
+{
+	if (!(TCCR1B & (_BV(CS12) | _BV(CS11) | _BV(CS10)))) {
+		// timer stopped (no motor driver), use same mode as motor_lld
+		TCNT1 = 0;
+		TCCR1A = _BV(WGM10);
+		TCCR1B = _BV(WGM12) | _BV(CS11);
+	}
+	TIMSK |= _BV(TOIE1);
+}
+
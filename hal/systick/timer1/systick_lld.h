@@ -0,0 +1,43 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** System tick on Timer1 overflow
+ * @file systick/timer1/systick_lld.h
+ *
+ * Used where all timers are taken (OR-AVR-M32-D): Timer1 is shared
+ * with the motor PWM (fast PWM 8-bit, 1/8), so tick is F_CPU/8/256.
+ */
+
+#ifndef SYSTICKLLD_H
+#define SYSTICKLLD_H
+
+#include <stdint.h>
+
+#define SYSTICK_LLD_HZ (F_CPU / 8 / 256)
+
+void systick_lld_init(void);
+uint16_t systick_lld_get(void);
+uint32_t systick_lld_cycles(void);
+
+#endif // SYSTICKLLD_H
+
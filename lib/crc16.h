@@ -0,0 +1,55 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** CRC-16
+ * @file crc16.h
+ *
+ * CRC-16/MCRF4XX: CCITT polynomial 0x1021 (reflected 0x8408),
+ * initial value 0xFFFF, no final xor. Same as avr-libc
+ * _crc_ccitt_update(), check value for "123456789" is 0x6F91.
+ */
+
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <stdint.h>
+
+/// Initial CRC value
+#define CRC16_INIT 0xFFFF
+
+/** Add one byte to CRC
+ * @param crc current CRC
+ * @param data next byte
+ * @return new CRC
+ */
+static inline uint16_t crc16_update(uint16_t crc, uint8_t data)
+{
+	data ^= (uint8_t) crc;
+	data ^= data << 4;
+
+	return ((((uint16_t) data << 8) | (crc >> 8))
+			^ (uint8_t) (data >> 4)
+			^ ((uint16_t) data << 3));
+}
+
+#endif // !defined CRC16_H
@@ -0,0 +1,156 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Small formatted output
+ * @file fmt.c
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "fmt.h"
+#include "hex.h"
+
+static const uint16_t dec_pow[] PROGMEM = { 10000, 1000, 100, 10 };
+
+/// Decimal digits of the last dec16(), most significant first
+static char digits[5];
+
+/** Convert to five decimal digits
+ * @return number of significant digits, at least 1
+ */
+static uint8_t dec16(uint16_t v)
+{
+	uint8_t n;
+
+	for (uint8_t i=0; i < 4; i++) {
+		uint16_t p = pgm_read_word(&dec_pow[i]);
+		char d = '0';
+		while (v >= p) {
+			v -= p;
+			d++;
+		}
+		digits[i] = d;
+	}
+	digits[4] = '0' + v;
+
+	for (n = 5; n > 1 && digits[5 - n] == '0'; n--);
+	return n;
+}
+
+/** Put last n digits, point before last frac of them (0 -- no point)
+ */
+static void put_digits(uint8_t n, uint8_t frac)
+{
+	for (uint8_t i = 5 - n; i < 5; i++) {
+		if (frac && i == 5 - frac) {
+			putchar('.');
+		}
+		putchar(digits[i]);
+	}
+}
+
+void fmt_str(const char *s)
+{
+	while (*s) {
+		putchar(*s++);
+	}
+}
+
+void fmt_str_P(PGM_P s)
+{
+	char c;
+
+	while ((c = pgm_read_byte(s++))) {
+		putchar(c);
+	}
+}
+
+void fmt_u8(uint8_t v)
+{
+	bool lead = false;
+	char d;
+
+	if (v >= 100) {
+		for (d = '0'; v >= 100; d++) {
+			v -= 100;
+		}
+		putchar(d);
+		lead = true;
+	}
+	if (v >= 10 || lead) {
+		for (d = '0'; v >= 10; d++) {
+			v -= 10;
+		}
+		putchar(d);
+	}
+	putchar('0' + v);
+}
+
+void fmt_u16(uint16_t v)
+{
+	put_digits(dec16(v), 0);
+}
+
+void fmt_u32(uint32_t v)
+{
+	if (v <= 0xffff) {
+		fmt_u16(v);
+		return;
+	}
+	// rare (statistics): two divisions are fine here
+	fmt_u32(v / 10000);
+	dec16(v % 10000);
+	put_digits(4, 0);
+}
+
+void fmt_s16(int16_t v)
+{
+	if (v < 0) {
+		putchar('-');
+		fmt_u16(-(uint16_t) v);
+	} else {
+		fmt_u16(v);
+	}
+}
+
+void fmt_hex8(uint8_t v)
+{
+	putchar(itox(v >> 4));
+	putchar(itox(v & 0xf));
+}
+
+void fmt_hex16(uint16_t v)
+{
+	fmt_hex8(v >> 8);
+	fmt_hex8(v & 0xff);
+}
+
+void fmt_fixed(uint16_t v, uint8_t frac)
+{
+	uint8_t n = dec16(v);
+
+	if (n <= frac) {
+		n = frac + 1;
+	}
+	put_digits(n, frac);
+}
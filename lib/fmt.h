@@ -0,0 +1,84 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Small formatted output
+ * @file fmt.h
+ *
+ * printf() replacement for eTerm responses: each emitter writes one
+ * value with putchar(), so nothing pulls vfprintf in. Decimal digits
+ * come from subtracting powers of ten, no division on 8/16-bit values.
+ *
+ * @code
+ * // printf("%c%d:%d.%02d\n", port, pin, v / 100, v % 100);
+ * putchar(port);
+ * fmt_u8(pin);
+ * putchar(':');
+ * fmt_fixed(v, 2);
+ * putchar('\n');
+ * @endcode
+ */
+
+#ifndef FMT_H
+#define FMT_H
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+/** Put string from RAM
+ */
+void fmt_str(const char *s);
+
+/** Put string from flash
+ * @code
+ * fmt_str_P(PSTR("AdcBits=10\n"));
+ * @endcode
+ */
+void fmt_str_P(PGM_P s);
+
+/** Put unsigned decimal
+ * @{
+ */
+void fmt_u8(uint8_t v);
+void fmt_u16(uint16_t v);
+void fmt_u32(uint32_t v);
+///@}
+
+/** Put signed decimal
+ */
+void fmt_s16(int16_t v);
+
+/** Put two/four uppercase hex digits
+ * @{
+ */
+void fmt_hex8(uint8_t v);
+void fmt_hex16(uint16_t v);
+///@}
+
+/** Put fixed point decimal
+ * fmt_fixed(330, 2) -> "3.30", fmt_fixed(5, 2) -> "0.05"
+ * @param v     value in units of 10^-frac
+ * @param frac  digits after the point, 0..4
+ */
+void fmt_fixed(uint16_t v, uint8_t frac);
+
+#endif // !defined FMT_H
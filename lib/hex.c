@@ -27,34 +27,68 @@
  * @author Vladimir Ermakov <vooon341@gmail.com>
  */
 
+#include <avr/pgmspace.h>
 #include "hex.h"
 
+static const char hex_digits[16] PROGMEM = "0123456789ABCDEF";
+
+#define X 0xff
+/// Nibble values of '0' -- 'f', X -- not a hex digit
+static const uint8_t hex_values['f' - '0' + 1] PROGMEM = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, X, X, X, X, X, X, // 0 -- ?
+	X, 10, 11, 12, 13, 14, 15, X, X, X, X, X, X, X, X, X, // @ -- O
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, // P -- _
+	X, 10, 11, 12, 13, 14, 15, // ` -- f
+};
+#undef X
+
+/// Nibble value of c, 0xff if c is not a hex digit
+static inline uint8_t hex_value(uint8_t c)
+{
+	c -= '0';
+	if (c > 'f' - '0')
+		return 0xff;
+	return pgm_read_byte(&hex_values[c]);
+}
+
 /* Convert a 4-bit integer value to its ASCII representation.
  */
 char itox(uint8_t c)
 {
-	char ret;
-
-	if (c <= 0x09) {
-		ret = '0' + c;
-	} else if (c <= 0x0f) {
-		ret = 'A' + c - 10;
-	} else {
-		ret = 'X';
-	}
-	return ret;
+	if (c > 0x0f)
+		return 'X';
+	return pgm_read_byte(&hex_digits[c]);
 }
 
 /* Convert hex to int8 (0 — 15)
  */
 int8_t xtoi(uint8_t c)
 {
-	if ((c >= '0')&&(c <= '9')) {
-		return c - '0';
-	} else if ((c >= 'A')&&(c <= 'F')) {
-		return c - 'A' + 10;
-	} else {
-		return -1;
+	return (int8_t) hex_value(c);
+}
+
+char *hex_encode(char *dst, const uint8_t *src, uint8_t len)
+{
+	while (len--) {
+		uint8_t b = *src++;
+		*dst++ = pgm_read_byte(&hex_digits[b >> 4]);
+		*dst++ = pgm_read_byte(&hex_digits[b & 0x0f]);
 	}
+	return dst;
 }
 
+uint8_t hex_decode(uint8_t *dst, const char *src, uint8_t len)
+{
+	uint8_t n;
+
+	for (n = 0; n < len; n++) {
+		uint8_t hi = hex_value(*src++);
+		if (hi & 0xf0)
+			break;
+		uint8_t lo = hex_value(*src++);
+		if (lo & 0xf0)
+			break;
+		*dst++ = (hi << 4) | lo;
+	}
+	return n;
+}
@@ -40,9 +40,32 @@
 char itox(uint8_t c);
 
 /** Convert hex to int8 (0 — 15)
- * @param[in] c 0 — 9, A — F
+ * @param[in] c 0 — 9, A — F, a — f
  * @return -1 if fail
  */
 int8_t xtoi(uint8_t c);
 
+/** Encode bytes as uppercase hex, two chars per byte
+ *
+ * The result is not NUL-terminated.
+ *
+ * @param[out] dst buffer for 2 * len chars
+ * @param[in] src bytes to encode
+ * @param[in] len number of bytes
+ * @return dst + 2 * len
+ */
+char *hex_encode(char *dst, const uint8_t *src, uint8_t len);
+
+/** Decode hex pairs to bytes
+ *
+ * Both upper and lower case digits are accepted. Decoding stops at the
+ * first pair that holds a non-hex char, a NUL included.
+ *
+ * @param[out] dst buffer for len bytes
+ * @param[in] src 2 * len chars
+ * @param[in] len number of bytes
+ * @return number of bytes decoded
+ */
+uint8_t hex_decode(uint8_t *dst, const char *src, uint8_t len);
+
 #endif // !defined HEX_H
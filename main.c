@@ -29,6 +29,7 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <avr/interrupt.h>
 
 #include "eterm/eterm_main.h"
 #include "core/i2cadapter.h"
@@ -36,9 +37,29 @@
 #include "hal/i2c.h"
 
 // -- virtual slave --
+//
+// Writes are not applied in the TWI interrupt: received records are
+// queued and i2c_slave_task applies them. Reads are served from adapter
+// windows (data the producers keep up to date) without adapter calls.
+//
+// Still run in the interrupt, with SCL stretched:
+// - reads of registers without a window (gate_register_read);
+// - queued writes, when a read has to see them ("write, repeated
+//   START, read") or the queue is full.
+// A read is not deferred to the task: that would stretch SCL for a
+// whole scheduler pass, longer than the adapter call it saves.
+//
+// The handlers are called from the TWI interrupt, or from a task for
+// local requests (see route_local in the HAL). The HAL posts
+// GATE_EVT_I2C at the end of a transaction in both cases, so the
+// handlers don't post events.
 
 #define BUF_LEN 65
 
+/// Write queue length (power of 2)
+#define WQ_LEN  128
+#define WQ_MASK (WQ_LEN - 1)
+
 #define GET_REGISTER true
 #define GET_DATA     false
 static bool state_i2c = GET_REGISTER;
@@ -46,13 +67,143 @@ static bool state_i2c = GET_REGISTER;
 static uint8_t register_addr = 0x00;
 static uint8_t buf[BUF_LEN];
 static uint8_t data_len = 0;
-static uint8_t* read_ptr;
+static const uint8_t* read_ptr;
+static uint16_t read_len = 0;
+static bool window_open = false;
+static uint8_t window_reg;
 static bool is_restart = false;
 static bool is_read = false;
 static bool prev_is_read = false;
 static bool read_always = false;
+static bool burst = false;
 static GATE_RESULT result = GR_OK;
 
+// write queue: records of [register byte][length][data...]
+static uint8_t wq[WQ_LEN];
+static uint8_t wq_head = 0; ///< first queued record
+static uint8_t wq_tail = 0; ///< end of queued records
+static uint8_t wq_end = 0;  ///< end of record being received
+static uint8_t wq_buf[BUF_LEN - 1];
+
+/** Apply queued writes
+ */
+static void wq_apply(void)
+{
+	while (wq_head != wq_tail) {
+		uint8_t reg = wq[wq_head];
+		uint8_t len = wq[(wq_head + 1) & WQ_MASK];
+		uint8_t i = (wq_head + 2) & WQ_MASK;
+
+		for (uint8_t n=0; n < len; n++) {
+			wq_buf[n] = wq[i];
+			i = (i + 1) & WQ_MASK;
+		}
+		wq_head = i;
+
+		debug("%% `-> gate_register_write(0x%02X, buf, %d)\n", reg, len);
+		if (reg & GATE_REG_BURST) {
+			result = gate_register_write_burst(reg & GATE_REG_MASK, wq_buf, len);
+		} else {
+			result = gate_register_write(reg, wq_buf, len);
+		}
+	}
+}
+
+/** Free bytes in write queue, record being received included
+ */
+static inline uint8_t wq_free(void)
+{
+	return (wq_head - wq_end - 1) & WQ_MASK;
+}
+
+/** Start receiving write record
+ */
+static void wq_begin(void)
+{
+	wq_end = wq_tail;
+	if (wq_free() < 2) {
+		wq_apply();
+	}
+	wq_end = (wq_tail + 2) & WQ_MASK;
+	data_len = 0;
+}
+
+/** Release register window, if any
+ */
+static void window_close(void)
+{
+	if (window_open) {
+		window_open = false;
+		read_len = 0;
+		gate_register_window_release(window_reg);
+	}
+}
+
+/** Read register(s)
+ * Stream from adapter window when it has one, otherwise read into buf
+ */
+static void register_read(void)
+{
+	uint8_t len = BUF_LEN - 1;
+
+	// read must see all writes before it
+	wq_apply();
+
+	window_close();
+	if (!burst &&
+		gate_register_window(register_addr, &read_ptr, &read_len) == GR_OK)
+	{
+		window_open = true;
+		window_reg = register_addr;
+		result = GR_OK;
+		debug("%% `-> gate_register_window(0x%02X, ptr, %d)\n", register_addr, read_len);
+		return;
+	}
+
+	if (burst) {
+		result = gate_register_read_burst(register_addr, buf, &len);
+	} else {
+		result = gate_register_read(register_addr, buf, &len);
+	}
+	read_ptr = buf;
+	read_len = len;
+	debug("%% `-> gate_register_read(0x%02X, buf, %d)\n", register_addr, len);
+}
+
+/** Queue received write
+ */
+static void register_write(void)
+{
+	wq[wq_tail] = register_addr | (burst ? GATE_REG_BURST : 0);
+	wq[(wq_tail + 1) & WQ_MASK] = data_len;
+	wq_tail = wq_end;
+	data_len = 0;
+}
+
+/** Apply queued writes
+ * Slave events are held back meanwhile, so adapters are never entered
+ * from the interrupt and the task at once.
+ */
+static void i2c_slave_task(void)
+{
+	i2c_lock();
+	wq_apply();
+	i2c_unlock();
+}
+
+static GATE_TASK i2c_task = {
+	.task = i2c_slave_task,
+	.events = GATE_EVT_I2C,
+};
+
+/// Master transfer timeout check period
+#define I2C_CHECK_MS 5
+
+static GATE_TASK i2c_check_task = {
+	.task = i2c_check,
+	.period = SYSTICK_MS(I2C_CHECK_MS),
+};
+
 /** Handle I2C Start event
  * @param[in] address device address
  * @param[in] flag Write/Read flag
@@ -63,22 +214,21 @@ bool i2c_start_handler(uint8_t flag)
 	debug("%% > i2c_start_handler(0x%02x, %i)\n", 0, flag);
 
 	if (is_restart && !is_read && data_len > 0) {
-		debug("%% `-> gate_register_write(0x%02X, buf, %d)\n", register_addr, data_len);
-		result = gate_register_write(register_addr, buf+1, data_len);
-		data_len = 0;
+		register_write();
 	}
 
 	state_i2c = GET_REGISTER;
 	is_read = (flag == 0) ? false : true;
 	is_restart = true;
 
+	if (!is_read) {
+		wq_begin();
+	}
+
 	if ((is_read && !prev_is_read) || 
-		(is_read && (!data_len || read_always)))
+		(is_read && (!read_len || read_always)))
 	{
-		data_len = BUF_LEN - 1;
-		read_ptr = buf;
-		result = gate_register_read(register_addr, buf, &data_len);
-		debug("%% `-> gate_register_read(0x%02X, buf, %d)\n", register_addr, data_len);
+		register_read();
 	}
 
 	prev_is_read = is_read;
@@ -93,10 +243,9 @@ void i2c_stop_handler(void)
 	debug("%% > i2c_stop_handler()\n");
 
 	is_restart = false;
+	window_close();
 	if (!is_read) {
-		debug("%% `-> gate_register_write(0x%02X, buf, %d)\n", register_addr, data_len);
-		result = gate_register_write(register_addr, buf+1, data_len);
-		data_len = 0;
+		register_write();
 	}
 }
 
@@ -106,20 +255,27 @@ void i2c_stop_handler(void)
  */
 bool i2c_txc_handler(uint8_t c)
 {
+	debug("%% > i2c_txc_handler(0x%02x)\n", c);
+
 	if (state_i2c) {
 		// Get register
-		read_always = c & 0x80;
-		register_addr = c & ~0x80;
+		read_always = c & GATE_REG_READ_ALWAYS;
+		burst = c & GATE_REG_BURST;
+		register_addr = c & GATE_REG_MASK;
 		state_i2c = GET_DATA;
-	} else {
-		// Get data
-		if ((++data_len) < BUF_LEN)
-			buf[data_len] = c;
-		else
-			data_len = BUF_LEN - 1;
+		return true;
 	}
 
-	debug("%% > i2c_txc_handler(0x%02x)\n", c);
+	// Get data
+	if (data_len >= BUF_LEN - 1) {
+		return false;
+	}
+	if (!wq_free()) {
+		wq_apply();
+	}
+	wq[wq_end] = c;
+	wq_end = (wq_end + 1) & WQ_MASK;
+	data_len++;
 	return true;
 }
 
@@ -130,16 +286,13 @@ bool i2c_txc_handler(uint8_t c)
  */
 bool i2c_rxc_handler(uint8_t *c, bool *ack)
 {
-	if (!data_len) {
-		data_len = BUF_LEN - 1;
-		read_ptr = buf;
-		result = gate_register_read(register_addr, buf, &data_len);
-		debug("%% ,-> gate_register_read(0x%02X, buf, %d)\n", register_addr, data_len);
+	if (!read_len) {
+		register_read();
 	}
 
-	if (data_len > 0) {
+	if (read_len > 0) {
 		*c = *read_ptr++;
-		--data_len;
+		--read_len;
 	} else {
 		*c = 0;
 	}
@@ -155,8 +308,11 @@ SYSTEM_INIT()
 	// Set I2C
 	i2c_set_evt_handlers(i2c_start_handler, i2c_stop_handler);
 	i2c_set_slave_handlers(i2c_txc_handler, i2c_rxc_handler);
+	gate_task_register(&i2c_task);
+	gate_task_register(&i2c_check_task);
 	// register supertask
 	gate_supertask_register(eterm_supertask);
+	gate_supertask_set_events(ETERM_SUPERTASK_EVENTS);
 	// register introspection driver
 	gate_init_introspection();
 	// init gate deivces
@@ -167,7 +323,7 @@ SYSTEM_INIT()
  */
 int main(void)
 {
-	asm volatile ("sei");
+	sei();
 	gate_scheduler_loop();
 	return 0;
 }
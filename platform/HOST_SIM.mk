@@ -0,0 +1,25 @@
+# -*- Makefile -*-
+
+BOARD_NAME = 'HOST-SIM'
+
+## Board whose pinout and adapter set the simulator reproduces
+SIM_BOARD = OR_AVR_M32_D
+
+MCU = host
+F_CPU = 7372800UL
+BAUD = B_AUTO
+
+ADAPTERS = ports adc motor servo
+MACROS = yes
+TELEMETRY = yes
+BINMODE = yes
+
+DEFINES += -D$(SIM_BOARD)
+INCLUDE_DIRS += -I${ORFA}/platform/host
+SRC += ${ORFA}/platform/host/host.c
+
+# native build: AVR-only layout options must not leak into libc calls
+CFLAGS = -std=gnu99 -I${ORFA} $(INCLUDE_DIRS) -Wall -Os -Wstrict-prototypes  -Werror $(MCU_FLAGS) -g \
+		 -funsigned-char -funsigned-bitfields -ffunction-sections -fdata-sections \
+		 -fmerge-all-constants -fstrict-aliasing
+LDFLAGS = -pthread -Wl,--gc-sections
@@ -0,0 +1,71 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Host simulation: <avr/eeprom.h> replacement
+ * @file platform/host/avr/eeprom.h
+ *
+ * EEPROM addresses are offsets in host_eeprom, writes complete at once.
+ */
+
+#ifndef HOST_AVR_EEPROM_H
+#define HOST_AVR_EEPROM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "avr/io.h"
+
+#define eeprom_is_ready() 1
+#define eeprom_busy_wait() do { } while (0)
+
+static inline uint8_t eeprom_read_byte(const uint8_t* addr)
+{
+	return host_eeprom[(uintptr_t) addr];
+}
+
+static inline void eeprom_read_block(void* dst, const void* src, size_t len)
+{
+	memcpy(dst, host_eeprom + (uintptr_t) src, len);
+}
+
+static inline void eeprom_write_byte(uint8_t* addr, uint8_t value)
+{
+	host_eeprom_write((uintptr_t) addr, &value, 1);
+}
+
+static inline void eeprom_update_byte(uint8_t* addr, uint8_t value)
+{
+	host_eeprom_write((uintptr_t) addr, &value, 1);
+}
+
+static inline void eeprom_write_block(const void* src, void* dst, size_t len)
+{
+	host_eeprom_write((uintptr_t) dst, src, len);
+}
+
+static inline void eeprom_update_block(const void* src, void* dst, size_t len)
+{
+	host_eeprom_write((uintptr_t) dst, src, len);
+}
+
+#endif // HOST_AVR_EEPROM_H
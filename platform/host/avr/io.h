@@ -0,0 +1,69 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Host simulation: <avr/io.h> replacement
+ * @file platform/host/avr/io.h
+ *
+ * Only GPIO registers exist; peripherals have their own host back-ends.
+ */
+
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+
+#include <stdint.h>
+#include "host.h"
+
+#define _BV(bit) (1 << (bit))
+#define _SFR_MEM_ADDR(sfr) (&(sfr))
+#define _SFR_IO_ADDR(sfr) (&(sfr))
+
+#define bit_is_set(sfr, bit)   ((sfr) & _BV(bit))
+#define bit_is_clear(sfr, bit) (!((sfr) & _BV(bit)))
+#define loop_until_bit_is_set(sfr, bit)   do { } while (bit_is_clear(sfr, bit))
+#define loop_until_bit_is_clear(sfr, bit) do { } while (bit_is_set(sfr, bit))
+
+#define E2END (HOST_EEPROM_SIZE - 1)
+
+#define PINA  (host_gpio[0].pin)
+#define DDRA  (host_gpio[0].ddr)
+#define PORTA (host_gpio[0].port)
+#define PINB  (host_gpio[1].pin)
+#define DDRB  (host_gpio[1].ddr)
+#define PORTB (host_gpio[1].port)
+#define PINC  (host_gpio[2].pin)
+#define DDRC  (host_gpio[2].ddr)
+#define PORTC (host_gpio[2].port)
+#define PIND  (host_gpio[3].pin)
+#define DDRD  (host_gpio[3].ddr)
+#define PORTD (host_gpio[3].port)
+#define PINE  (host_gpio[4].pin)
+#define DDRE  (host_gpio[4].ddr)
+#define PORTE (host_gpio[4].port)
+#define PINF  (host_gpio[5].pin)
+#define DDRF  (host_gpio[5].ddr)
+#define PORTF (host_gpio[5].port)
+#define PING  (host_gpio[6].pin)
+#define DDRG  (host_gpio[6].ddr)
+#define PORTG (host_gpio[6].port)
+
+#endif // HOST_AVR_IO_H
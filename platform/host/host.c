@@ -0,0 +1,377 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Host simulation runtime
+ * @file platform/host/host.c
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <poll.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "host.h"
+
+#define MAX_TIMERS 8
+#define MAX_FDS    4
+
+/// Longest simulation thread wait without timers
+#define IDLE_POLL_US 10000
+
+typedef struct {
+	host_isr_t isr;
+	uint32_t period;
+	uint64_t next;
+} host_timer_t;
+
+HOST_GPIO host_gpio[HOST_GPIO_PORTS];
+
+// interrupt flag: the main thread holds irq_lock while its interrupts
+// are disabled, the simulation thread holds it while running an ISR
+static pthread_mutex_t irq_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread bool irq_on;
+
+static pthread_mutex_t sleep_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sleep_cond = PTHREAD_COND_INITIALIZER;
+static unsigned irq_count;
+static unsigned sleep_mark;
+static volatile bool exit_when_idle;
+static volatile int busy_count;
+
+static pthread_mutex_t src_lock = PTHREAD_MUTEX_INITIALIZER;
+static host_timer_t timers[MAX_TIMERS];
+static uint8_t num_timers;
+static struct pollfd fds[MAX_FDS];
+static host_fd_handler_t fd_handlers[MAX_FDS];
+static uint8_t num_fds;
+
+static uint32_t wdt_timeout;
+static uint64_t wdt_deadline;
+static bool wdt_off;
+
+static char** host_argv;
+
+uint8_t host_eeprom[HOST_EEPROM_SIZE];
+static int eeprom_fd = -1;
+
+static uint64_t now_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// -- interrupts --
+
+void host_irq_disable(void)
+{
+	if (irq_on) {
+		pthread_mutex_lock(&irq_lock);
+		irq_on = false;
+	}
+}
+
+void host_irq_enable(void)
+{
+	if (!irq_on) {
+		irq_on = true;
+		pthread_mutex_unlock(&irq_lock);
+	}
+}
+
+uint8_t host_irq_save(void)
+{
+	uint8_t state = irq_on;
+	host_irq_disable();
+	return state;
+}
+
+void host_irq_restore(uint8_t state)
+{
+	if (state) {
+		host_irq_enable();
+	} else {
+		host_irq_disable();
+	}
+}
+
+void host_irq_run(host_isr_t isr)
+{
+	pthread_mutex_lock(&irq_lock);
+	irq_on = false;
+	isr();
+
+	pthread_mutex_lock(&sleep_lock);
+	irq_count++;
+	pthread_cond_broadcast(&sleep_cond);
+	pthread_mutex_unlock(&sleep_lock);
+
+	if (irq_on) {
+		// handler did sei(), lock is already released
+		irq_on = false;
+	} else {
+		pthread_mutex_unlock(&irq_lock);
+	}
+}
+
+// -- sleep --
+
+void host_sleep_enable(void)
+{
+	pthread_mutex_lock(&sleep_lock);
+	sleep_mark = irq_count;
+	pthread_mutex_unlock(&sleep_lock);
+}
+
+void host_sleep_cpu(void)
+{
+	if (exit_when_idle && !busy_count) {
+		exit(EXIT_SUCCESS);
+	}
+
+	pthread_mutex_lock(&sleep_lock);
+	while (irq_count == sleep_mark) {
+		pthread_cond_wait(&sleep_cond, &sleep_lock);
+	}
+	pthread_mutex_unlock(&sleep_lock);
+}
+
+void host_exit_when_idle(void)
+{
+	exit_when_idle = true;
+}
+
+void host_busy(bool busy)
+{
+	busy_count += busy ? 1 : -1;
+}
+
+// -- sources --
+
+void host_timer_add(host_isr_t isr, uint32_t period_us)
+{
+	pthread_mutex_lock(&src_lock);
+	if (num_timers < MAX_TIMERS) {
+		timers[num_timers].isr = isr;
+		timers[num_timers].period = period_us;
+		timers[num_timers].next = now_us() + period_us;
+		num_timers++;
+	}
+	pthread_mutex_unlock(&src_lock);
+}
+
+void host_fd_add(int fd, host_fd_handler_t ready)
+{
+	pthread_mutex_lock(&src_lock);
+	if (num_fds < MAX_FDS) {
+		fds[num_fds].fd = fd;
+		fds[num_fds].events = POLLIN;
+		fd_handlers[num_fds] = ready;
+		num_fds++;
+	}
+	pthread_mutex_unlock(&src_lock);
+}
+
+void host_fd_remove(int fd)
+{
+	uint8_t i;
+
+	pthread_mutex_lock(&src_lock);
+	for (i = 0; i < num_fds; i++) {
+		if (fds[i].fd == fd) {
+			num_fds--;
+			fds[i] = fds[num_fds];
+			fd_handlers[i] = fd_handlers[num_fds];
+			break;
+		}
+	}
+	pthread_mutex_unlock(&src_lock);
+}
+
+// -- watchdog --
+
+void host_wdt_enable(uint8_t code)
+{
+	wdt_timeout = 15000UL << code;
+	wdt_deadline = now_us() + wdt_timeout;
+}
+
+void host_wdt_disable(void)
+{
+	wdt_timeout = 0;
+}
+
+void host_wdt_reset(void)
+{
+	wdt_deadline = now_us() + wdt_timeout;
+}
+
+static void wdt_check(uint64_t now)
+{
+	if (wdt_off || !wdt_timeout || now < wdt_deadline) {
+		return;
+	}
+
+	host_log("host: watchdog reset\n");
+	execv("/proc/self/exe", host_argv);
+	host_log("host: can't restart\n");
+	_exit(EXIT_FAILURE);
+}
+
+// -- EEPROM --
+
+void host_eeprom_write(uint16_t addr, const void* src, uint16_t len)
+{
+	if (addr > HOST_EEPROM_SIZE || len > HOST_EEPROM_SIZE - addr) {
+		host_log("host: EEPROM write out of range: 0x%04x+%u\n", addr, len);
+		return;
+	}
+
+	memcpy(host_eeprom + addr, src, len);
+	if (eeprom_fd >= 0 && pwrite(eeprom_fd, host_eeprom + addr, len, addr) != len) {
+		host_log("host: can't write EEPROM file\n");
+	}
+}
+
+static void eeprom_init(const char* path)
+{
+	memset(host_eeprom, 0xff, sizeof(host_eeprom));
+	if (!path) {
+		return;
+	}
+
+	eeprom_fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (eeprom_fd < 0) {
+		host_log("host: can't open EEPROM file %s\n", path);
+		return;
+	}
+	// bytes past the end of a short file read as erased
+	if (pread(eeprom_fd, host_eeprom, sizeof(host_eeprom), 0) < 0) {
+		host_log("host: can't read EEPROM file %s\n", path);
+	}
+}
+
+// -- GPIO --
+
+void host_gpio_input(uint8_t port, uint8_t mask, uint8_t value)
+{
+	if (port < HOST_GPIO_PORTS) {
+		host_gpio[port].ext_mask = mask;
+		host_gpio[port].ext = value;
+	}
+}
+
+static void gpio_update(void)
+{
+	uint8_t i;
+
+	for (i = 0; i < HOST_GPIO_PORTS; i++) {
+		HOST_GPIO* g = host_gpio + i;
+		uint8_t in = (g->ext & g->ext_mask) | (g->port & ~g->ext_mask);
+		g->pin = (g->port & g->ddr) | (in & ~g->ddr);
+	}
+}
+
+// -- simulation thread --
+
+static void* sim_thread(void* arg)
+{
+	struct pollfd pfds[MAX_FDS];
+	host_fd_handler_t handlers[MAX_FDS];
+	host_timer_t* t;
+	uint8_t i, n;
+	(void)arg;
+
+	for (;;) {
+		uint64_t now = now_us();
+		uint64_t wait = IDLE_POLL_US;
+		struct timespec ts;
+
+		pthread_mutex_lock(&src_lock);
+		for (i = 0; i < num_timers; i++) {
+			t = timers + i;
+			if (t->next <= now) {
+				wait = 0;
+			} else if (t->next - now < wait) {
+				wait = t->next - now;
+			}
+		}
+		n = num_fds;
+		memcpy(pfds, fds, sizeof(pfds));
+		memcpy(handlers, fd_handlers, sizeof(handlers));
+		pthread_mutex_unlock(&src_lock);
+
+		ts.tv_sec = wait / 1000000;
+		ts.tv_nsec = (wait % 1000000) * 1000;
+		if (ppoll(pfds, n, &ts, NULL) > 0) {
+			for (i = 0; i < n; i++) {
+				if (pfds[i].revents) {
+					handlers[i](pfds[i].fd);
+				}
+			}
+		}
+
+		now = now_us();
+		gpio_update();
+		wdt_check(now);
+
+		for (i = 0; i < num_timers; i++) {
+			t = timers + i;
+			if (now > t->next && now - t->next > 100 * (uint64_t) t->period) {
+				// way behind (stopped in debugger?), resync
+				t->next = now;
+			}
+			while (t->next <= now) {
+				host_irq_run(t->isr);
+				t->next += t->period;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+__attribute__((constructor(101)))
+static void host_init(int argc, char** argv, char** envp)
+{
+	pthread_t thread;
+	const char* env = getenv("ORFA_SIM_WDT");
+	(void)argc;
+	(void)envp;
+
+	host_argv = argv;
+	wdt_off = env && !strcmp(env, "0");
+	eeprom_init(getenv("ORFA_SIM_EEPROM"));
+
+	// firmware starts with interrupts disabled
+	pthread_mutex_lock(&irq_lock);
+	irq_on = false;
+
+	pthread_create(&thread, NULL, sim_thread, NULL);
+	pthread_detach(thread);
+}
@@ -0,0 +1,159 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Host simulation runtime
+ * @file platform/host/host.h
+ *
+ * Firmware code runs in the main thread. A simulation thread stands in
+ * for the interrupt hardware: it runs timer and I/O handlers as
+ * interrupts, serialized against the main thread by cli()/sei().
+ */
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/// Handler run in interrupt context
+typedef void (*host_isr_t)(void);
+
+/// Handler for a readable file descriptor (simulation thread)
+typedef void (*host_fd_handler_t)(int fd);
+
+// -- interrupts --
+
+/** Disable interrupts (cli)
+ */
+void host_irq_disable(void);
+
+/** Enable interrupts (sei)
+ */
+void host_irq_enable(void);
+
+/** Disable interrupts, return previous state
+ */
+uint8_t host_irq_save(void);
+
+/** Restore state saved by host_irq_save()
+ */
+void host_irq_restore(uint8_t state);
+
+/** Run isr as an interrupt
+ * Waits until interrupts are enabled in the firmware.
+ * @note Simulation thread only.
+ */
+void host_irq_run(host_isr_t isr);
+
+// -- sleep --
+
+/** Arm sleep (call with interrupts disabled)
+ */
+void host_sleep_enable(void);
+
+/** Sleep until an interrupt has run since host_sleep_enable()
+ */
+void host_sleep_cpu(void);
+
+// -- simulation thread sources --
+
+/** Add periodic interrupt
+ * @param[in] isr handler
+ * @param[in] period_us period in microseconds
+ */
+void host_timer_add(host_isr_t isr, uint32_t period_us);
+
+/** Watch file descriptor for input
+ * @param[in] fd file descriptor
+ * @param[in] ready called from the simulation thread when fd is readable
+ */
+void host_fd_add(int fd, host_fd_handler_t ready);
+
+/** Remove file descriptor from the watch list
+ */
+void host_fd_remove(int fd);
+
+/** Exit the process next time the firmware goes idle
+ */
+void host_exit_when_idle(void);
+
+/** Simulated hardware has work in flight, don't exit while idle
+ * Calls nest, each host_busy(true) needs a host_busy(false).
+ */
+void host_busy(bool busy);
+
+// -- watchdog --
+
+void host_wdt_enable(uint8_t code);
+void host_wdt_disable(void);
+void host_wdt_reset(void);
+
+// -- GPIO --
+
+/// Number of simulated ports (A..G)
+#define HOST_GPIO_PORTS 7
+
+/** Simulated port registers
+ */
+typedef struct {
+	volatile uint8_t pin;  /**< PINx, refreshed by the simulation thread */
+	volatile uint8_t ddr;  /**< DDRx */
+	volatile uint8_t port; /**< PORTx */
+	uint8_t ext_mask;      /**< Inputs driven from outside */
+	uint8_t ext;           /**< External input levels */
+} HOST_GPIO;
+
+extern HOST_GPIO host_gpio[HOST_GPIO_PORTS];
+
+/** Drive input pins from outside
+ * Undriven inputs read back as their pull-up (PORTx) bit.
+ * @param[in] port port index (0 -- A)
+ * @param[in] mask pins to drive (0 releases all pins)
+ * @param[in] value pin levels
+ */
+void host_gpio_input(uint8_t port, uint8_t mask, uint8_t value);
+
+// -- EEPROM --
+
+/// Simulated EEPROM size (ATmega32)
+#define HOST_EEPROM_SIZE 1024
+
+/** EEPROM contents, erased (0xFF) at start
+ * Loaded from the file named by ORFA_SIM_EEPROM, if set.
+ */
+extern uint8_t host_eeprom[HOST_EEPROM_SIZE];
+
+/** Write EEPROM bytes
+ * Written through to the ORFA_SIM_EEPROM file, if any.
+ * @param[in] addr EEPROM address
+ * @param[in] src data
+ * @param[in] len data length
+ */
+void host_eeprom_write(uint16_t addr, const void* src, uint16_t len);
+
+/** Original stderr, for simulator messages
+ */
+#define host_log(...) dprintf(2, __VA_ARGS__)
+
+#endif // HOST_H
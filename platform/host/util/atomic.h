@@ -0,0 +1,57 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** Host simulation: <util/atomic.h> replacement
+ * @file platform/host/util/atomic.h
+ *
+ * Same contract as avr-libc: state is restored on any exit from the
+ * block, including return.
+ */
+
+#ifndef HOST_UTIL_ATOMIC_H
+#define HOST_UTIL_ATOMIC_H
+
+#include <stdint.h>
+#include "host.h"
+
+static inline void host_atomic_restore(const uint8_t* state)
+{
+	host_irq_restore(*state);
+}
+
+static inline void host_atomic_forceon(const uint8_t* state)
+{
+	(void)state;
+	host_irq_enable();
+}
+
+#define ATOMIC_RESTORESTATE \
+	uint8_t host_atomic_state __attribute__((cleanup(host_atomic_restore))) = host_irq_save()
+
+#define ATOMIC_FORCEON \
+	uint8_t host_atomic_state __attribute__((cleanup(host_atomic_forceon))) = host_irq_save()
+
+#define ATOMIC_BLOCK(type) \
+	for (type, host_atomic_todo = 1; host_atomic_todo; host_atomic_todo = 0)
+
+#endif // HOST_UTIL_ATOMIC_H
@@ -9,6 +9,11 @@ ifeq ($(DEBUG),0)
 else
 	DEFINES += -DDEBUG=$(DEBUG)
 endif
+ifeq ($(PLATFORM),HOST_SIM)
+    MCU_FLAGS = -DF_CPU=$(F_CPU)
+    CROSS_COMPILE_GCC =
+    CROSS_COMPILE_BIN =
+endif
 ifeq ($(DEBUG),2)
     MCU_FLAGS =
     CROSS_COMPILE_GCC =
@@ -21,3 +26,15 @@ include adapters/resolve.mk
 include hal/resolve.mk
 include lib/resolve.mk
 
+
+ifeq ($(BENCH),yes)
+include bench/resolve.mk
+endif
+
+ifeq ($(FUZZ),yes)
+include fuzz/resolve.mk
+endif
+
+ifeq ($(TWITEST),yes)
+include twitest/resolve.mk
+endif
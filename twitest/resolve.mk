@@ -0,0 +1,20 @@
+# -*- Makefile -*-
+# TWI test image (TWITEST=yes, see `make twi_test` in debug.mk):
+# twitest/twitest.c replaces main.c and the AVR I2C driver
+# (hal/i2c/i2c_lld.c) replaces the host one, built against the register
+# stand-ins in twitest/util. The test plays the bus: it sets the TWI
+# status and calls the interrupt, as the hardware does.
+
+ifneq ($(PLATFORM),HOST_SIM)
+    $(error the TWI test runs on the host, use PLATFORM=HOST_SIM)
+endif
+
+target = ${ORFA}/twitest/orfa_twitest
+SRC := $(filter-out main.c,$(SRC)) ${ORFA}/twitest/twitest.c
+HAL_SRC := $(filter-out %/host/i2c_lld.c,$(HAL_SRC)) ${ORFA}/hal/i2c/i2c_lld.c
+INCLUDE_DIRS += -I${ORFA}/twitest
+
+# the poll cache is read too
+ifeq ($(filter poll,$(ADAPTERS)),)
+include ${ORFA}/adapters/poll/resolve.mk
+endif
@@ -0,0 +1,253 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** AVR TWI driver test
+ * @file twitest/twitest.c
+ *
+ * Built instead of main.c by `make twi_test` (PLATFORM=HOST_SIM, see
+ * twitest/resolve.mk), with hal/i2c/i2c_lld.c in place of the host I2C
+ * back-end. main.c is included, so the firmware runs as usual; a test
+ * task plays the bus master: it sets TWSR (and TWDR) as the hardware
+ * would and calls the TWI interrupt, one step per task run, so the
+ * adapters' tasks run in between as they do on the bus.
+ *
+ * Checked: a register window read over the bus is released when the
+ * read ends (TW_ST_LAST_DATA or TW_ST_DATA_NACK), and the adapter
+ * publishes again: the ADC table, and the poll cache, filled by a
+ * master transfer to a simulated device.
+ *
+ * Exit status 0 if all checks pass.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <util/atomic.h>
+#include <util/twi.h>
+
+#define main firmware_main
+#include "main.c"
+#undef main
+
+#include "hal/adc.h"
+#include "poll_i2c.h"
+
+/// ADC adapter uid and its result table register
+#define ADC_UID       0x0040
+#define ADC_TABLE_REG 2
+
+/// Polled device: 8-bit address, register, its value
+#define DEV_ADDR      0x42
+#define DEV_REG       0x05
+#define DEV_VALUE     0x5A
+
+// registers of the TWI image
+volatile uint8_t TWBR, TWSR, TWAR, TWDR, TWCR;
+
+static uint8_t step;
+static systick_t wake;
+static uint8_t adc_base;
+static uint8_t poll_base;
+
+/** Fail the test
+ */
+static void fail(const char* what)
+{
+	host_log("twi_test: %s\n", what);
+	exit(1);
+}
+
+/** Raise a TWI event
+ */
+static void twi_event(uint8_t status)
+{
+	TWSR = status;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		SIG_2WIRE_SERIAL();
+	}
+}
+
+/** Read registers over the bus: write the register address, repeated
+ * START, read len bytes
+ * @param[in] end status after the last byte, TW_ST_LAST_DATA or
+ *                TW_ST_DATA_NACK
+ */
+static void bus_read(uint8_t reg, uint8_t* data, uint8_t len, uint8_t end)
+{
+	twi_event(TW_SR_SLA_ACK);
+	TWDR = reg;
+	twi_event(TW_SR_DATA_ACK);
+	twi_event(TW_SR_STOP); // repeated START
+	twi_event(TW_ST_SLA_ACK);
+	for (uint8_t i=0; i < len; i++) {
+		data[i] = TWDR;
+		twi_event(i + 1 < len ? TW_ST_DATA_ACK : end);
+	}
+}
+
+/** Write registers over the bus
+ */
+static void bus_write(uint8_t reg, const uint8_t* data, uint8_t len)
+{
+	twi_event(TW_SR_SLA_ACK);
+	TWDR = reg;
+	twi_event(TW_SR_DATA_ACK);
+	for (uint8_t i=0; i < len; i++) {
+		TWDR = data[i];
+		twi_event(TW_SR_DATA_ACK);
+	}
+	twi_event(TW_SR_STOP);
+}
+
+/** Answer the pending master transfer as the polled device: register
+ * address written, repeated START, one byte read
+ */
+static void device_answer(void)
+{
+	twi_event(TW_START);
+	if (TWDR != (DEV_ADDR | TW_WRITE)) {
+		fail("no poll transfer");
+	}
+	twi_event(TW_MT_SLA_ACK);
+	if (TWDR != DEV_REG) {
+		fail("wrong device register");
+	}
+	twi_event(TW_MT_DATA_ACK);
+	twi_event(TW_REP_START);
+	if (TWDR != (DEV_ADDR | TW_READ)) {
+		fail("no read phase");
+	}
+	twi_event(TW_MR_SLA_ACK);
+	TWDR = DEV_VALUE;
+	twi_event(TW_MR_DATA_NACK);
+}
+
+/** First register of the adapter, through the introspection register
+ */
+static uint8_t adapter_base(uint16_t uid)
+{
+	uint8_t d[6] = { 0 };
+	uint8_t len = 1;
+
+	gate_register_write(0, d, 1);
+	gate_register_read(0, d, &len);
+	for (uint8_t n = d[0]; n; n--) {
+		len = sizeof(d);
+		gate_register_write(0, &n, 1);
+		gate_register_read(0, d, &len);
+		if (((d[0] << 8) | d[1]) == uid) {
+			return d[4];
+		}
+	}
+	fail("adapter not found");
+	return 0;
+}
+
+/** Check a big endian u16 pair
+ */
+static void check_pair(const uint8_t* d, uint16_t a, uint16_t b,
+	const char* what)
+{
+	if (((d[0] << 8) | d[1]) != a || ((d[2] << 8) | d[3]) != b) {
+		host_log("twi_test: %04X %04X, expected %04X %04X\n",
+			(d[0] << 8) | d[1], (d[2] << 8) | d[3], a, b);
+		fail(what);
+	}
+}
+
+static void test_task(void)
+{
+	// poll entry 0: 1 byte, every 1000 ms
+	static const uint8_t entry[] = { 0, DEV_ADDR, DEV_REG, 1, 0x03, 0xE8 };
+	static uint8_t clear[] = { 1 };
+	uint8_t d[POLL_CACHE_REC];
+
+	if (!systick_after_eq(systick_get(), wake)) {
+		return;
+	}
+	wake = systick_get() + SYSTICK_MS(5);
+
+	switch (step++) {
+		case 0:
+			adc_base = adapter_base(ADC_UID);
+			setenv("ORFA_SIM_ADC", "100,200", 1);
+			adc_reconfigure(0x03);
+			break;
+
+		case 1:
+			bus_read(adc_base + ADC_TABLE_REG, d, 4, TW_ST_LAST_DATA);
+			check_pair(d, 100, 200, "ADC table");
+			setenv("ORFA_SIM_ADC", "300,400", 1);
+			adc_reconfigure(0x03);
+			break;
+
+		case 2:
+			// a window left open holds the table
+			bus_read(adc_base + ADC_TABLE_REG, d, 4, TW_ST_LAST_DATA);
+			check_pair(d, 300, 400, "ADC table not republished after a read");
+
+			poll_base = adapter_base(POLL_UID);
+			bus_write(poll_base + POLL_LIST_REG, entry, sizeof(entry));
+			break;
+
+		case 3:
+			device_answer();
+			break;
+
+		case 4:
+			bus_read(poll_base + POLL_CACHE_REG, d, sizeof(d), TW_ST_DATA_NACK);
+			if (d[0] != (POLL_F_VALID | POLL_F_FRESH) || d[1] != I2C_E_OK ||
+				d[4] != DEV_VALUE)
+			{
+				fail("poll cache");
+			}
+			// the list is cleared, so are the records; not over the bus,
+			// its STOP would close a window left open
+			gate_register_write(poll_base + POLL_CTRL_REG, clear, sizeof(clear));
+			break;
+
+		case 5:
+			// a window left open holds the cache
+			bus_read(poll_base + POLL_CACHE_REG, d, sizeof(d), TW_ST_DATA_NACK);
+			if (d[0] || d[4]) {
+				fail("poll cache not republished after a read");
+			}
+			break;
+
+		default:
+			host_log("twi_test: ok\n");
+			exit(0);
+	}
+}
+
+static GATE_TASK twi_test_task = {
+	.task = test_task,
+	.period = SYSTICK_MS(1),
+};
+
+int main(void)
+{
+	gate_task_register(&twi_test_task);
+	// the test ends the run, not the end of input
+	host_busy(true);
+	return firmware_main();
+}
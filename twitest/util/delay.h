@@ -1,7 +1,7 @@
 /*
  *  ORFA -- Open Robotics Firmware Architecture
  *
- *  Copyright (c) 2010 Vladimir Ermakov
+ *  Copyright (c) 2011 ORFA developers
  *
  *  Permission is hereby granted, free of charge, to any person obtaining a copy
  *  of this software and associated documentation files (the "Software"), to deal
@@ -21,27 +21,18 @@
  *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  *  THE SOFTWARE.
  *****************************************************************************/
-/** test for eTerm
- * @file eterm/tests.c
+/** TWI test image: <util/delay.h> replacement
+ * @file twitest/util/delay.h
  *
- * @author Vladimir Ermakov <vooon341@gmail.com>
+ * The lines are not modelled, bus recovery doesn't need to wait.
  */
 
-#include "eterm.h"
+#ifndef TWITEST_UTIL_DELAY_H
+#define TWITEST_UTIL_DELAY_H
 
-bool register_serialgate(void);
-bool register_orc32(void);
-
-int main(int argv, char *argc[]) {
-	register_serialgate();
-	register_orc32();
-	register_help();
-
-	while (true) {
-		char c = getchar();
-		bool res = parse_command(c, false);
-	}
-
-	return 0;
+static inline void _delay_us(double us)
+{
+	(void)us;
 }
 
+#endif // TWITEST_UTIL_DELAY_H
@@ -0,0 +1,99 @@
+/*
+ *  ORFA -- Open Robotics Firmware Architecture
+ *
+ *  Copyright (c) 2011 ORFA developers
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ *****************************************************************************/
+/** TWI test image: <util/twi.h> replacement
+ * @file twitest/util/twi.h
+ *
+ * hal/i2c/i2c_lld.c is built for the host against these registers.
+ * Nothing drives them but the test: it sets TWSR (and TWDR) as the
+ * hardware would and calls the TWI vector, a plain function here.
+ */
+
+#ifndef TWITEST_UTIL_TWI_H
+#define TWITEST_UTIL_TWI_H
+
+#include <stdint.h>
+
+extern volatile uint8_t TWBR;
+extern volatile uint8_t TWSR;
+extern volatile uint8_t TWAR;
+extern volatile uint8_t TWDR;
+extern volatile uint8_t TWCR;
+
+// TWCR bits
+#define TWIE  0
+#define TWEN  2
+#define TWWC  3
+#define TWSTO 4
+#define TWSTA 5
+#define TWEA  6
+#define TWINT 7
+
+// bus recovery pins
+#define PC0 0
+#define PC1 1
+#define PC4 4
+#define PC5 5
+#define PD0 0
+#define PD1 1
+
+#define ISR(vector) void vector(void)
+
+/** TWI interrupt
+ */
+void SIG_2WIRE_SERIAL(void);
+
+#define TW_READ  1
+#define TW_WRITE 0
+
+// status codes, as in avr-libc
+#define TW_START                 0x08
+#define TW_REP_START             0x10
+#define TW_MT_SLA_ACK            0x18
+#define TW_MT_SLA_NACK           0x20
+#define TW_MT_DATA_ACK           0x28
+#define TW_MT_DATA_NACK          0x30
+#define TW_MT_ARB_LOST           0x38
+#define TW_MR_ARB_LOST           0x38
+#define TW_MR_SLA_ACK            0x40
+#define TW_MR_SLA_NACK           0x48
+#define TW_MR_DATA_ACK           0x50
+#define TW_MR_DATA_NACK          0x58
+#define TW_ST_SLA_ACK            0xA8
+#define TW_ST_ARB_LOST_SLA_ACK   0xB0
+#define TW_ST_DATA_ACK           0xB8
+#define TW_ST_DATA_NACK          0xC0
+#define TW_ST_LAST_DATA          0xC8
+#define TW_SR_SLA_ACK            0x60
+#define TW_SR_ARB_LOST_SLA_ACK   0x68
+#define TW_SR_GCALL_ACK          0x70
+#define TW_SR_ARB_LOST_GCALL_ACK 0x78
+#define TW_SR_DATA_ACK           0x80
+#define TW_SR_DATA_NACK          0x88
+#define TW_SR_GCALL_DATA_ACK     0x90
+#define TW_SR_GCALL_DATA_NACK    0x98
+#define TW_SR_STOP               0xA0
+#define TW_NO_INFO               0xF8
+#define TW_BUS_ERROR             0x00
+
+#endif // TWITEST_UTIL_TWI_H